@@ -4,13 +4,21 @@
 #include <GLFW/glfw3.h> 
 #include <al.h>      
 #include <unordered_map>
+#include <unordered_set>
+#include "tagRead.h"
+#include "albumArt.h"
+#include "pcmCache.h"
 
 struct AppState {
     std::vector<std::string> mp3Files;
+    std::vector<std::string> displayNames;
+    std::unordered_set<std::string> mp3FileSet;
     std::vector<std::string> remainingTracks;
 
     std::string selectedFile;
     std::string audioFilePath;
+    // Last track handed to EngineSetNext.
+    std::string queuedNextTrack;
     
     static int selectedTab;
     
@@ -27,12 +35,20 @@ struct AppState {
     float currentTime = 0.0f;
     float previousTime = 0.0f;
     float volume = 0.5f;
+    float crossfadeSeconds = 0.0f;
+    int crossfadeCurve = 1;
+    int pcmCacheBudgetMB = PCM_CACHE_BUDGET / (1024 * 1024);
+    float trackLength = 0.0f;
+
+    std::unordered_map<std::string, float> trackLengths;
+    std::unordered_map<std::string, TrackInfo> trackInfos;
 
     GLuint albumArtTexture = 0;
     GLuint albumArtTexture2 = 0;
+    uint64_t albumArtHash = 0;
+    uint64_t albumArtHash2 = 0;
 
     ALuint buffer = 0;
 
-    std::unordered_map<std::string, GLuint> albumArtTextures; 
-    std::unordered_map<std::string, std::vector<unsigned char>> albumArtData;
+    AlbumArtCache albumArtCache;
 };
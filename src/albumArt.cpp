@@ -1,34 +1,89 @@
-#include <taglib/fileref.h>
-#include <taglib/tag.h>
-#include <taglib/tpropertymap.h>
-#include <taglib/mpegfile.h>
-#include <taglib/id3v2tag.h>
-#include <taglib/attachedpictureframe.h>
-#include <fstream>
+#include <algorithm>
 #include <iostream>
+#include <SOIL/SOIL.h>
 #include "albumArt.h"
 
-void extractCoverArt(const std::string &audioFilePath, const std::string &outputImagePath) {
-    TagLib::MPEG::File mpegFile(audioFilePath.c_str());
-    if (!mpegFile.isValid()) {
-        std::cerr << "Invalid audio file: " << audioFilePath << std::endl;
-        return;
+// Decodes the embedded picture (JPEG or PNG) straight from the tag bytes into a GL texture.
+GLuint LoadCoverArtTexture(const std::vector<unsigned char> &picture, size_t *bytes) {
+    if (picture.empty()) {
+        return 0;
     }
 
-    TagLib::ID3v2::Tag *id3v2Tag = mpegFile.ID3v2Tag();
-    if (!id3v2Tag) {
-        std::cerr << "No ID3v2 tag found in file: " << audioFilePath << std::endl;
-        return;
+    int width = 0, height = 0, channels = 0;
+    unsigned char *pixels = SOIL_load_image_from_memory(
+        picture.data(),
+        static_cast<int>(picture.size()),
+        &width, &height, &channels,
+        SOIL_LOAD_AUTO
+    );
+    if (!pixels) {
+        std::cerr << "Failed to decode cover art: " << SOIL_last_result() << std::endl;
+        return 0;
     }
 
-    TagLib::ID3v2::FrameList frames = id3v2Tag->frameListMap()["APIC"];
-    if (frames.isEmpty()) {
-        std::cerr << "No cover art found in file: " << audioFilePath << std::endl;
-        return;
+    GLuint texture = SOIL_create_OGL_texture(pixels, width, height, channels, SOIL_CREATE_NEW_ID, 0);
+    SOIL_free_image_data(pixels);
+
+    if (texture == 0) {
+        std::cerr << "Failed to create cover art texture: " << SOIL_last_result() << std::endl;
+    } else if (bytes) {
+        // Drivers usually expand to RGBA, so budget for four bytes per texel.
+        *bytes = static_cast<size_t>(width) * height * 4;
+    }
+    return texture;
+}
+
+GLuint FindCoverArt(AlbumArtCache &cache, uint64_t hash) {
+    auto it = cache.textures.find(hash);
+    if (it == cache.textures.end()) {
+        return 0;
+    }
+    cache.lru.splice(cache.lru.begin(), cache.lru, it->second.lruPos);
+    return it->second.texture;
+}
+
+GLuint AcquireCoverArt(AlbumArtCache &cache, uint64_t hash, const std::vector<unsigned char> &picture) {
+    if (hash == 0 || picture.empty()) {
+        return 0;
+    }
+    if (GLuint texture = FindCoverArt(cache, hash)) {
+        return texture;
     }
 
-    TagLib::ID3v2::AttachedPictureFrame *coverArtFrame = static_cast<TagLib::ID3v2::AttachedPictureFrame *>(frames.front());
-    std::ofstream outFile(outputImagePath, std::ios::binary);
-    outFile.write(coverArtFrame->picture().data(), coverArtFrame->picture().size());
-    outFile.close();
+    AlbumArtTexture entry;
+    entry.texture = LoadCoverArtTexture(picture, &entry.bytes);
+    if (entry.texture == 0) {
+        return 0;
+    }
+    cache.lru.push_front(hash);
+    entry.lruPos = cache.lru.begin();
+    cache.usedBytes += entry.bytes;
+    cache.textures[hash] = entry;
+    return entry.texture;
+}
+
+void TrimCoverArtCache(AlbumArtCache &cache, std::initializer_list<uint64_t> keep) {
+    auto it = cache.lru.end();
+    while (cache.usedBytes > cache.budgetBytes && it != cache.lru.begin()) {
+        --it;
+        uint64_t hash = *it;
+        if (std::find(keep.begin(), keep.end(), hash) != keep.end()) {
+            continue;
+        }
+
+        AlbumArtTexture &entry = cache.textures[hash];
+        glDeleteTextures(1, &entry.texture);
+        cache.usedBytes -= entry.bytes;
+        cache.textures.erase(hash);
+        it = cache.lru.erase(it);
+    }
+}
+
+void ClearCoverArtCache(AlbumArtCache &cache) {
+    for (auto &entry : cache.textures) {
+        glDeleteTextures(1, &entry.second.texture);
+    }
+    cache.textures.clear();
+    cache.lru.clear();
+    cache.usedBytes = 0;
 }
\ No newline at end of file
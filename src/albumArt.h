@@ -1,14 +1,37 @@
 #ifndef ALBUMART_H
 #define ALBUMART_H
 
-#include <taglib/fileref.h>
-#include <taglib/tag.h>
-#include <taglib/tpropertymap.h>
-#include <taglib/mpegfile.h>
-#include <taglib/id3v2tag.h>
-#include <taglib/attachedpictureframe.h>
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <GLFW/glfw3.h>
 
-void extractCoverArt(const std::string &audioFilePath, const std::string &outputImagePath);
+#define ALBUM_ART_VRAM_BUDGET (64u * 1024u * 1024u)
+
+struct AlbumArtTexture {
+    GLuint texture = 0;
+    size_t bytes = 0;
+    std::list<uint64_t>::iterator lruPos;
+};
+
+// Cover-art textures keyed by the hash of the picture bytes, so tracks of one album share a texture.
+struct AlbumArtCache {
+    size_t budgetBytes = ALBUM_ART_VRAM_BUDGET;
+    size_t usedBytes = 0;
+    std::list<uint64_t> lru;
+    std::unordered_map<uint64_t, AlbumArtTexture> textures;
+};
+
+GLuint LoadCoverArtTexture(const std::vector<unsigned char> &picture, size_t *bytes = nullptr);
+
+// Returns the cached texture for hash, or 0 if it is not resident. A hit marks it most recently used.
+GLuint FindCoverArt(AlbumArtCache &cache, uint64_t hash);
+GLuint AcquireCoverArt(AlbumArtCache &cache, uint64_t hash, const std::vector<unsigned char> &picture);
+// Deletes least recently used textures until the cache fits its budget; hashes in keep are never evicted.
+void TrimCoverArtCache(AlbumArtCache &cache, std::initializer_list<uint64_t> keep);
+void ClearCoverArtCache(AlbumArtCache &cache);
 
 #endif // ALBUMART_H
\ No newline at end of file
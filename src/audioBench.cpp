@@ -0,0 +1,178 @@
+// Headless benchmark of the playback path: every track is streamed through the same OpenStream /
+// UpdateStream code as the player, mixed by an ALC_SOFT_loopback device as fast as the CPU allows,
+// and the mixed output is hashed so it can be checked bit-exactly against stored references.
+//
+// Usage: echoa-play-bench [--queue] [--int16] [--hashes FILE [--record]] <file or folder>...
+#include "playmusic.h"
+#include "decoderPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#define BENCH_RATE 48000
+#define BENCH_BLOCK_FRAMES 1024
+// Safety stop for a source that never reports the end of its stream.
+#define BENCH_MAX_SECONDS (3 * 3600)
+
+namespace fs = std::filesystem;
+
+// 64-bit FNV-1a, continued across calls.
+static uint64_t HashUpdate(uint64_t hash, const unsigned char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void CollectTracks(const std::string& path, std::vector<std::string>* tracks) {
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+        tracks->push_back(path);
+        return;
+    }
+    std::vector<std::string> found;
+    for (fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec), end;
+         it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().extension() == ".mp3") {
+            found.push_back(it->path().string());
+        }
+    }
+    // Directory order is filesystem dependent; sort so runs are comparable.
+    std::sort(found.begin(), found.end());
+    tracks->insert(tracks->end(), found.begin(), found.end());
+}
+
+// Reference file: one "<16 hex digits> <path>" line per track.
+static std::map<std::string, uint64_t> LoadHashes(const std::string& file) {
+    std::map<std::string, uint64_t> hashes;
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos) continue;
+        hashes[line.substr(space + 1)] = std::strtoull(line.substr(0, space).c_str(), nullptr, 16);
+    }
+    return hashes;
+}
+
+static bool SaveHashes(const std::string& file, const std::map<std::string, uint64_t>& hashes) {
+    std::ofstream out(file, std::ios::trunc);
+    for (const auto& entry : hashes) {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(entry.second));
+        out << hex << ' ' << entry.first << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+struct RenderResult {
+    uint64_t hash = 14695981039346656037ULL;
+    uint64_t frames = 0;
+    double seconds = 0.0;
+};
+
+// Plays one track to its end on the loopback device, refilling the stream after every block the
+// way the engine thread does after a buffer-completed event.
+static bool RenderTrack(const std::string& path, RenderResult* result) {
+    auto start = std::chrono::steady_clock::now();
+    if (!OpenStream(path.c_str())) return false;
+
+    std::vector<float> block(BENCH_BLOCK_FRAMES * 2);
+    alSourcePlay(source);
+    while (!IsStreamFinished() && result->frames < static_cast<uint64_t>(BENCH_MAX_SECONDS) * BENCH_RATE) {
+        RenderLoopback(block.data(), BENCH_BLOCK_FRAMES);
+        result->hash = HashUpdate(result->hash, reinterpret_cast<const unsigned char*>(block.data()),
+                                  block.size() * sizeof(float));
+        result->frames += BENCH_BLOCK_FRAMES;
+        UpdateStream();
+    }
+    CloseStream();
+    result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string hashFile;
+    bool record = false;
+    std::vector<std::string> tracks;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--queue") == 0) {
+            SetCallbackOutput(false);
+        } else if (std::strcmp(argv[i], "--int16") == 0) {
+            SetFloatDecode(false);
+        } else if (std::strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else if (std::strcmp(argv[i], "--hashes") == 0 && i + 1 < argc) {
+            hashFile = argv[++i];
+        } else {
+            CollectTracks(argv[i], &tracks);
+        }
+    }
+    if (tracks.empty() || (record && hashFile.empty())) {
+        std::cerr << "Usage: " << argv[0] << " [--queue] [--int16] [--hashes FILE [--record]] <file or folder>..." << std::endl;
+        return 2;
+    }
+
+    InitDecoderPool();
+    if (!InitOpenALLoopback(BENCH_RATE)) {
+        ShutdownDecoderPool();
+        return 1;
+    }
+
+    std::map<std::string, uint64_t> hashes;
+    if (!hashFile.empty() && !record) hashes = LoadHashes(hashFile);
+
+    int failures = 0;
+    uint64_t totalFrames = 0;
+    double totalSeconds = 0.0;
+    for (const std::string& path : tracks) {
+        RenderResult result;
+        if (!RenderTrack(path, &result)) {
+            std::printf("FAIL      %s (could not open)\n", path.c_str());
+            ++failures;
+            continue;
+        }
+        totalFrames += result.frames;
+        totalSeconds += result.seconds;
+
+        const char* status = "";
+        if (record) {
+            hashes[path] = result.hash;
+        } else if (!hashFile.empty()) {
+            auto it = hashes.find(path);
+            if (it == hashes.end()) {
+                status = " no reference";
+            } else if (it->second != result.hash) {
+                status = " MISMATCH";
+                ++failures;
+            } else {
+                status = " ok";
+            }
+        }
+        double audioSeconds = static_cast<double>(result.frames) / BENCH_RATE;
+        std::printf("%8.1fx  %016llx  %7.1fs  %s%s\n", audioSeconds / std::max(result.seconds, 1e-9),
+                    static_cast<unsigned long long>(result.hash), audioSeconds, path.c_str(), status);
+    }
+
+    double totalAudio = static_cast<double>(totalFrames) / BENCH_RATE;
+    std::printf("%zu tracks, %.1f s of audio in %.2f s: %.1fx realtime\n", tracks.size(), totalAudio, totalSeconds,
+                totalAudio / std::max(totalSeconds, 1e-9));
+
+    CleanupOpenAL();
+    ShutdownDecoderPool();
+
+    if (record && !SaveHashes(hashFile, hashes)) {
+        std::cerr << "Failed to write " << hashFile << std::endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+#include "audioEngine.h"
+#include "playmusic.h"
+#include "seekIndex.h"
+#include "mappedFile.h"
+#include "wakeSignal.h"
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// With AL_SOFT_events the engine sleeps until OpenAL or the UI wakes it; while playing, the timeout
+// paces clock updates, which the UI interpolates between. Without the extension it falls back to
+// polling the source. Paused or idle, it waits without a timeout.
+#define ENGINE_EVENT_WAIT_MS 50
+#define ENGINE_POLL_WAIT_MS 10
+
+EngineStatus engineStatus;
+
+static SpscQueue<EngineCommand, 64> commandQueue;
+static SpscQueue<EngineEvent, 64> eventQueue;
+static std::thread engineThread;
+static std::atomic<int> initResult{0};
+static void (*eventNotifier)() = nullptr;
+
+// Every wake goes through one lock-free signal, so commands, scan results, OpenAL's event thread and
+// the mixer thread's buffer callback can all wake the engine without taking a lock.
+static WakeSignal wakeSignal;
+
+static float engineVolume = 0.5f;
+static std::string currentPath;
+static std::string nextPath;
+static std::string preparedPath;
+
+// One mpg123_scan pass off the engine thread. It caches the track's seek index and yields the exact
+// length of a VBR file without a usable header.
+struct LengthScan {
+    std::string path;
+    bool reportLength = false;
+    std::atomic<bool> done{false};
+    std::atomic<bool> cancelled{false};
+    float seconds = 0.0f;
+};
+static std::shared_ptr<LengthScan> pendingScan;
+
+// Scans run one at a time on a worker owned by the engine, which StopAudioEngine joins. Only the
+// latest request is kept: a newer one drops a queued scan and cancels a running one.
+static std::thread scanThread;
+static std::mutex scanMutex;
+static std::condition_variable scanCv;
+static std::shared_ptr<LengthScan> queuedScan;
+static bool scanQuit = false;
+
+static void PostEvent(EngineEventType type, const std::string& path = std::string(), float duration = 0.0f) {
+    EngineEvent event;
+    event.type = type;
+    event.path = path;
+    event.duration = duration;
+    if (!eventQueue.push(std::move(event))) {
+        std::cerr << "Audio engine event queue is full" << std::endl;
+    }
+    if (eventNotifier) eventNotifier();
+}
+
+// Safe to call from any thread, including OpenAL's event and mixer threads.
+static void WakeEngine() {
+    wakeSignal.notify();
+}
+
+static void WaitForWake(int milliseconds) {
+    wakeSignal.wait(milliseconds);
+}
+
+static void SendCommand(EngineCommandType type, float value = 0.0f, const std::string& path = std::string(), int option = 0) {
+    EngineCommand cmd;
+    cmd.type = type;
+    cmd.value = value;
+    cmd.option = option;
+    cmd.path = path;
+    while (!commandQueue.push(std::move(cmd))) {
+        std::this_thread::yield();
+    }
+    WakeEngine();
+}
+
+static void PublishClock() {
+    int64_t latencyNs = 0;
+    int64_t samples = GetStreamSamplePosition(&latencyNs);
+    engineStatus.clock.publish(samples, latencyNs, stream.rate, engineStatus.playing);
+}
+
+// Reports the header length right away. A background mpg123_scan follows if the length is only an
+// estimate or the track has no cached seek index yet.
+static void PublishTrackLength(EngineEventType type) {
+    bool accurate = false;
+    float length = GetStreamLength(&accurate);
+    PostEvent(type, currentPath, length);
+
+    if (pendingScan) pendingScan->cancelled = true;
+    pendingScan.reset();
+    if (accurate && HasSeekIndex(currentPath)) return;
+
+    auto scan = std::make_shared<LengthScan>();
+    scan->path = currentPath;
+    scan->reportLength = !accurate;
+    pendingScan = scan;
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        queuedScan = scan;
+    }
+    scanCv.notify_one();
+}
+
+static void ScanThreadMain() {
+    while (true) {
+        std::shared_ptr<LengthScan> scan;
+        {
+            std::unique_lock<std::mutex> lock(scanMutex);
+            scanCv.wait(lock, [] { return scanQuit || queuedScan; });
+            if (scanQuit) return;
+            scan = std::move(queuedScan);
+        }
+        if (scan->cancelled) continue;
+        scan->seconds = IndexTrack(scan->path, &scan->cancelled);
+        scan->done = true;
+        WakeEngine();
+    }
+}
+
+static void HandleCommand(const EngineCommand& cmd) {
+    switch (cmd.type) {
+    case EngineCommandType::Load:
+        engineStatus.playing = false;
+        currentPath = cmd.path;
+        preparedPath.clear();
+        if (!OpenStream(cmd.path.c_str())) {
+            engineStatus.loaded = false;
+            PostEvent(EngineEventType::LoadFailed, cmd.path);
+            break;
+        }
+        alSourcef(source, AL_GAIN, engineVolume);
+        engineStatus.loaded = true;
+        PublishClock();
+        PublishTrackLength(EngineEventType::Loaded);
+        break;
+    case EngineCommandType::Play:
+        if (engineStatus.loaded) {
+            alSourcePlay(source);
+            engineStatus.playing = true;
+            PublishClock();
+        }
+        break;
+    case EngineCommandType::Pause:
+        alSourcePause(source);
+        engineStatus.playing = false;
+        PublishClock();
+        break;
+    case EngineCommandType::Seek:
+        DiscardNextStream();
+        preparedPath.clear();
+        SeekStream(cmd.value);
+        PublishClock();
+        break;
+    case EngineCommandType::Volume:
+        engineVolume = cmd.value;
+        alSourcef(source, AL_GAIN, engineVolume);
+        break;
+    case EngineCommandType::SetNext:
+        // Already queued: it has been prefetched and requested, and may already be prepared.
+        if (cmd.path == nextPath) break;
+        nextPath = cmd.path;
+        if (!nextPath.empty()) PrefetchFile(nextPath);
+        RequestTrackDecode(nextPath);
+        if (!preparedPath.empty() && preparedPath != nextPath) {
+            DiscardNextStream();
+            preparedPath.clear();
+        }
+        break;
+    case EngineCommandType::Crossfade:
+        SetCrossfade(cmd.value, static_cast<CrossfadeCurve>(cmd.option));
+        break;
+    case EngineCommandType::Quit:
+        break;
+    }
+}
+
+// Set from a disconnect until an output device could be reopened; the engine keeps retrying meanwhile.
+static bool deviceLost = false;
+
+// The output device went away: follow the new default device if possible, otherwise stop.
+static void HandleDeviceLost() {
+    if (ReopenOutputDevice()) {
+        deviceLost = false;
+        std::cerr << "Audio device changed, resuming on the default device" << std::endl;
+        if (engineStatus.loaded) {
+            SeekStream(static_cast<float>(engineStatus.clock.seconds()));
+            if (engineStatus.playing) alSourcePlay(source);
+            PublishClock();
+        }
+        return;
+    }
+    if (deviceLost) return;
+    deviceLost = true;
+    std::cerr << "Audio device disconnected" << std::endl;
+    alSourcePause(source);
+    engineStatus.playing = false;
+    PublishClock();
+    PostEvent(EngineEventType::DeviceLost, currentPath);
+}
+
+static void EngineThreadMain() {
+    if (!InitOpenAL(WakeEngine)) {
+        initResult = -1;
+        return;
+    }
+    initResult = 1;
+    bool polling = !HasAudioEvents();
+
+    bool running = true;
+    while (running) {
+        EngineCommand cmd;
+        while (commandQueue.pop(cmd)) {
+            if (cmd.type == EngineCommandType::Quit) {
+                running = false;
+                break;
+            }
+            HandleCommand(cmd);
+        }
+
+        unsigned events = polling ? AUDIO_EVENT_BUFFER_COMPLETED | AUDIO_EVENT_SOURCE_STOPPED : TakeAudioEvents();
+        // OpenAL reports a disconnect once, so a lost device is retried on every pass until it reopens.
+        if (deviceLost || ((events & (AUDIO_EVENT_DISCONNECTED | AUDIO_EVENT_SOURCE_STOPPED)) && !IsOutputConnected())) {
+            HandleDeviceLost();
+            events = 0;
+        }
+
+        if (engineStatus.loaded) {
+            // Open and pre-decode the next track early so its buffers can follow the current one,
+            // or in time for a crossfade to start mixing it in.
+            float preload = GAPLESS_PRELOAD_SECONDS + GetCrossfadeSeconds();
+            if (!nextPath.empty() && preparedPath != nextPath && GetStreamRemaining() < preload) {
+                PrepareNextStream(nextPath.c_str());
+                preparedPath = nextPath;
+            }
+
+            if (events & (AUDIO_EVENT_BUFFER_COMPLETED | AUDIO_EVENT_SOURCE_STOPPED)) {
+                UpdateStream();
+            }
+            if (AdvanceStreamTrack()) {
+                currentPath = preparedPath;
+                nextPath.clear();
+                preparedPath.clear();
+                PublishTrackLength(EngineEventType::TrackChanged);
+            }
+            if (engineStatus.playing) {
+                PublishClock();
+                engineStatus.underruns += TakeStreamUnderruns();
+                if (events & AUDIO_EVENT_SOURCE_STOPPED) {
+                    // A stop is either the end of the queue or an underrun; the refill above tells them apart.
+                    if (RecoverStreamUnderrun()) {
+                        engineStatus.underruns++;
+                    } else if (IsStreamFinished()) {
+                        engineStatus.playing = false;
+                        PublishClock();
+                        PostEvent(EngineEventType::TrackEnded, currentPath);
+                    }
+                }
+            }
+        }
+
+        if (pendingScan && pendingScan->done) {
+            if (pendingScan->path == currentPath) {
+                ApplyStreamSeekIndex(currentPath);
+            }
+            if (pendingScan->reportLength && pendingScan->seconds > 0.0f) {
+                PostEvent(EngineEventType::DurationUpdated, pendingScan->path, pendingScan->seconds);
+            }
+            pendingScan.reset();
+        }
+
+        // Only playback needs a timer, for the clock and output polling; otherwise sleep until woken.
+        bool timed = engineStatus.playing || deviceLost;
+        WaitForWake(!timed ? -1 : polling ? ENGINE_POLL_WAIT_MS : ENGINE_EVENT_WAIT_MS);
+    }
+
+    CleanupOpenAL();
+}
+
+bool StartAudioEngine() {
+    initResult = 0;
+    engineThread = std::thread(EngineThreadMain);
+    while (initResult == 0) {
+        std::this_thread::yield();
+    }
+    if (initResult < 0) {
+        engineThread.join();
+        return false;
+    }
+    scanQuit = false;
+    scanThread = std::thread(ScanThreadMain);
+    return true;
+}
+
+void StopAudioEngine() {
+    if (!engineThread.joinable()) return;
+    SendCommand(EngineCommandType::Quit);
+    engineThread.join();
+    if (pendingScan) pendingScan->cancelled = true;
+    pendingScan.reset();
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        scanQuit = true;
+        queuedScan.reset();
+    }
+    scanCv.notify_one();
+    scanThread.join();
+    ClearPcmCache();
+}
+
+void EngineLoad(const std::string& path) {
+    SendCommand(EngineCommandType::Load, 0.0f, path);
+}
+
+void EnginePlay() {
+    SendCommand(EngineCommandType::Play);
+}
+
+void EnginePause() {
+    SendCommand(EngineCommandType::Pause);
+}
+
+void EngineSeek(float seconds) {
+    SendCommand(EngineCommandType::Seek, seconds);
+}
+
+void EngineSetVolume(float volume) {
+    SendCommand(EngineCommandType::Volume, volume);
+}
+
+void EngineSetNext(const std::string& path) {
+    SendCommand(EngineCommandType::SetNext, 0.0f, path);
+}
+
+void EngineSetCrossfade(float seconds, CrossfadeCurve curve) {
+    SendCommand(EngineCommandType::Crossfade, seconds, std::string(), static_cast<int>(curve));
+}
+
+bool PollEngineEvent(EngineEvent& event) {
+    return eventQueue.pop(event);
+}
+
+void SetEngineEventNotifier(void (*notify)()) {
+    eventNotifier = notify;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <atomic>
+#include <string>
+#include "commandQueue.h"
+#include "playbackClock.h"
+
+enum class CrossfadeCurve;
+
+enum class EngineCommandType {
+    Load,
+    Play,
+    Pause,
+    Seek,
+    Volume,
+    SetNext,
+    Crossfade,
+    Quit
+};
+
+struct EngineCommand {
+    EngineCommandType type = EngineCommandType::Play;
+    float value = 0.0f;
+    // Second argument where one is needed, e.g. the curve for Crossfade.
+    int option = 0;
+    std::string path;
+};
+
+enum class EngineEventType {
+    Loaded,
+    LoadFailed,
+    TrackChanged,
+    TrackEnded,
+    DurationUpdated,
+    DeviceLost
+};
+
+struct EngineEvent {
+    EngineEventType type = EngineEventType::Loaded;
+    std::string path;
+    float duration = 0.0f;
+};
+
+// Playback state published by the engine thread. The UI only reads these.
+struct EngineStatus {
+    std::atomic<bool> loaded{false};
+    std::atomic<bool> playing{false};
+    PlaybackClock clock;
+    std::atomic<int> underruns{0};
+};
+
+bool StartAudioEngine();
+void StopAudioEngine();
+
+void EngineLoad(const std::string& path);
+void EnginePlay();
+void EnginePause();
+void EngineSeek(float seconds);
+void EngineSetVolume(float volume);
+void EngineSetNext(const std::string& path);
+void EngineSetCrossfade(float seconds, CrossfadeCurve curve);
+
+bool PollEngineEvent(EngineEvent& event);
+// Called on the engine thread after every event so the UI can wake up; set before StartAudioEngine.
+void SetEngineEventNotifier(void (*notify)());
+
+extern EngineStatus engineStatus;
+
+#endif // AUDIOENGINE_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded single-producer/single-consumer queue. One thread may push and one
+// other thread may pop without any locking; push fails when the queue is full.
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    bool push(T item) {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        size_t next = (head + 1) % Capacity;
+        if (next == readIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots[head] = std::move(item);
+        writeIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots[tail]);
+        readIndex.store((tail + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> slots;
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+#endif // COMMANDQUEUE_H
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "decoderPool.h"
+#include "seekIndex.h"
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+static std::once_flag initOnce;
+static bool initialized = false;
+static const char* cpuDecoder = nullptr;
+
+static std::mutex poolMutex;
+static std::vector<mpg123_handle*> freeDecoders;
+static bool poolOpen = false;
+
+static void InitMpg123() {
+    if (mpg123_init() != MPG123_OK) {
+        std::cerr << "Failed to initialize mpg123" << std::endl;
+        return;
+    }
+    // The first supported decoder is the fastest one this CPU can run.
+    const char** decoders = mpg123_supported_decoders();
+    if (decoders && decoders[0]) {
+        cpuDecoder = decoders[0];
+        std::cerr << "mpg123 decoder: " << cpuDecoder << std::endl;
+    }
+    initialized = true;
+}
+
+static mpg123_handle* CreateDecoder() {
+    int err;
+    mpg123_handle* mh = mpg123_new(cpuDecoder, &err);
+    if (!mh) {
+        std::cerr << "Failed to create mpg123 handle: " << mpg123_plain_strerror(err) << std::endl;
+        return nullptr;
+    }
+    mpg123_param(mh, MPG123_ADD_FLAGS, MPG123_GAPLESS, 0.0);
+    mpg123_param(mh, MPG123_INDEX_SIZE, SEEK_INDEX_ENTRIES, 0.0);
+    return mh;
+}
+
+bool InitDecoderPool() {
+    std::call_once(initOnce, InitMpg123);
+    if (!initialized) return false;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    poolOpen = true;
+    while (freeDecoders.size() < DECODER_POOL_SIZE) {
+        mpg123_handle* mh = CreateDecoder();
+        if (!mh) break;
+        freeDecoders.push_back(mh);
+    }
+    return true;
+}
+
+void ShutdownDecoderPool() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (mpg123_handle* mh : freeDecoders) {
+        mpg123_delete(mh);
+    }
+    freeDecoders.clear();
+    // Handles still checked out by detached jobs are deleted when they come back.
+    poolOpen = false;
+}
+
+mpg123_handle* AcquireDecoder() {
+    std::call_once(initOnce, InitMpg123);
+    if (!initialized) return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!freeDecoders.empty()) {
+            mpg123_handle* mh = freeDecoders.back();
+            freeDecoders.pop_back();
+            return mh;
+        }
+    }
+    return CreateDecoder();
+}
+
+void ReleaseDecoder(mpg123_handle* mh) {
+    if (!mh) return;
+    mpg123_close(mh);
+    // Stream decoders lock a single output format; the next file has to be able to pick its own.
+    mpg123_format_all(mh);
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (poolOpen && freeDecoders.size() < DECODER_POOL_SIZE) {
+        freeDecoders.push_back(mh);
+    } else {
+        mpg123_delete(mh);
+    }
+}
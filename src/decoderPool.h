@@ -0,0 +1,19 @@
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <mpg123.h>
+
+#define DECODER_POOL_SIZE 4
+
+// mpg123 is initialized once per process. Handles are created with the chosen CPU decoder, gapless
+// trimming and the seek-index size already set, and are reused across files instead of reallocating
+// their decoder tables. All functions are thread-safe.
+bool InitDecoderPool();
+void ShutdownDecoderPool();
+
+// Returns a closed, configured handle, or null if mpg123 cannot create one.
+mpg123_handle* AcquireDecoder();
+// Closes the file and resets the output format; handles beyond DECODER_POOL_SIZE are deleted.
+void ReleaseDecoder(mpg123_handle* mh);
+
+#endif // DECODERPOOL_H
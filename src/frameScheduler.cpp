@@ -0,0 +1,69 @@
+#include "frameScheduler.h"
+
+static double lastInputTime = 0.0;
+static double lastFrameTime = 0.0;
+static bool interacting = false;
+
+static void MarkInput() {
+    lastInputTime = glfwGetTime();
+}
+
+static void CursorPosCallback(GLFWwindow*, double, double) { MarkInput(); }
+static void MouseButtonCallback(GLFWwindow*, int, int, int) { MarkInput(); }
+static void ScrollCallback(GLFWwindow*, double, double) { MarkInput(); }
+static void KeyCallback(GLFWwindow*, int, int, int, int) { MarkInput(); }
+static void CharCallback(GLFWwindow*, unsigned int) { MarkInput(); }
+static void WindowFocusCallback(GLFWwindow*, int) { MarkInput(); }
+static void CursorEnterCallback(GLFWwindow*, int) { MarkInput(); }
+static void WindowRefreshCallback(GLFWwindow*) { MarkInput(); }
+static void WindowIconifyCallback(GLFWwindow*, int) { MarkInput(); }
+static void FramebufferSizeCallback(GLFWwindow*, int, int) { MarkInput(); }
+
+void InstallFrameSchedulerCallbacks(GLFWwindow* window) {
+    glfwSetCursorPosCallback(window, CursorPosCallback);
+    glfwSetMouseButtonCallback(window, MouseButtonCallback);
+    glfwSetScrollCallback(window, ScrollCallback);
+    glfwSetKeyCallback(window, KeyCallback);
+    glfwSetCharCallback(window, CharCallback);
+    glfwSetWindowFocusCallback(window, WindowFocusCallback);
+    glfwSetCursorEnterCallback(window, CursorEnterCallback);
+    glfwSetWindowRefreshCallback(window, WindowRefreshCallback);
+    glfwSetWindowIconifyCallback(window, WindowIconifyCallback);
+    glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+    MarkInput();
+}
+
+void WaitForNextFrame(GLFWwindow* window, bool playing, bool busy) {
+    if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) {
+        // Nothing is drawn, but engine and scan events still need handling on this thread.
+        glfwWaitEventsTimeout(FRAME_ICONIFIED_INTERVAL_SECONDS);
+        return;
+    }
+
+    double now = glfwGetTime();
+    if (interacting || now - lastInputTime < FRAME_INTERACTIVE_LINGER_SECONDS) {
+        glfwPollEvents();
+        return;
+    }
+
+    double interval = (playing || busy) ? FRAME_PLAYBACK_INTERVAL_SECONDS : FRAME_IDLE_INTERVAL_SECONDS;
+    double wait = lastFrameTime + interval - now;
+    if (wait > 0.0) {
+        glfwWaitEventsTimeout(wait);
+    } else {
+        glfwPollEvents();
+    }
+}
+
+bool ShouldRenderFrame(GLFWwindow* window) {
+    return !glfwGetWindowAttrib(window, GLFW_ICONIFIED);
+}
+
+void FrameRendered(bool active) {
+    interacting = active;
+    lastFrameTime = glfwGetTime();
+}
+
+void RequestFrame() {
+    glfwPostEmptyEvent();
+}
@@ -0,0 +1,26 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <GLFW/glfw3.h>
+
+#define FRAME_INTERACTIVE_LINGER_SECONDS 0.5
+#define FRAME_PLAYBACK_INTERVAL_SECONDS (1.0 / 10.0)
+#define FRAME_IDLE_INTERVAL_SECONDS 1.0
+#define FRAME_ICONIFIED_INTERVAL_SECONDS 0.25
+
+// Must be called before ImGui_ImplGlfw_InitForOpenGL so the ImGui backend chains these callbacks.
+void InstallFrameSchedulerCallbacks(GLFWwindow* window);
+
+// Blocks until the next frame is due or an event arrives. Full rate while the user interacts,
+// FRAME_PLAYBACK_INTERVAL_SECONDS while playing or scanning,
+// otherwise on events or every FRAME_IDLE_INTERVAL_SECONDS.
+void WaitForNextFrame(GLFWwindow* window, bool playing, bool busy);
+// False while the window is iconified; background work still runs, only drawing is skipped.
+bool ShouldRenderFrame(GLFWwindow* window);
+// Called after a frame is drawn; an active widget (e.g. a dragged slider) keeps the full rate.
+void FrameRendered(bool interacting);
+
+// Thread-safe: wakes the UI thread out of WaitForNextFrame.
+void RequestFrame();
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,226 @@
+#include "libraryIndex.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include "mappedFile.h"
+
+static const char indexMagic[8] = { 'E', 'C', 'H', 'O', 'A', 'I', 'D', 'X' };
+
+static std::mutex indexMutex;
+static std::vector<IndexEntry> indexEntries;
+static std::unordered_map<std::string, size_t> indexLookup;
+static bool indexDirty = false;
+
+std::string GetLibraryIndexPath() {
+    std::filesystem::path dir;
+#ifdef _WIN32
+    const wchar_t* appData = _wgetenv(L"APPDATA");
+    if (appData) dir = std::filesystem::path(appData);
+#else
+    const char* xdg = getenv("XDG_CONFIG_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg) dir = xdg;
+    else if (home) dir = std::filesystem::path(home) / ".config";
+#endif
+    if (dir.empty()) return "";
+    return (dir / "echoa-play" / "library.idx").u8string();
+}
+
+bool StatTrackFile(const std::string& path, uint64_t* size, int64_t* mtime) {
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::u8path(path);
+    *size = std::filesystem::file_size(p, ec);
+    if (ec) return false;
+    *mtime = std::filesystem::last_write_time(p, ec).time_since_epoch().count();
+    return !ec;
+}
+
+struct IndexReader {
+    const unsigned char* pos;
+    const unsigned char* end;
+
+    template <typename T>
+    bool read(T* value) {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) return false;
+        memcpy(value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool readString(std::string* value) {
+        uint32_t length;
+        if (!read(&length) || static_cast<size_t>(end - pos) < length) return false;
+        value->assign(reinterpret_cast<const char*>(pos), length);
+        pos += length;
+        return true;
+    }
+};
+
+struct IndexWriter {
+    std::vector<unsigned char> bytes;
+
+    template <typename T>
+    void write(const T& value) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+        bytes.insert(bytes.end(), p, p + sizeof(T));
+    }
+
+    void writeString(const std::string& value) {
+        write(static_cast<uint32_t>(value.size()));
+        bytes.insert(bytes.end(), value.begin(), value.end());
+    }
+};
+
+bool LoadLibraryIndex() {
+    std::string path = GetLibraryIndexPath();
+    if (path.empty()) return false;
+
+    MappedFile mapped;
+    if (!MapFile(path, &mapped)) return false;
+
+    IndexReader reader{ mapped.data, mapped.data + mapped.size };
+    char magic[8];
+    uint32_t version = 0, count = 0;
+    bool ok = reader.read(&magic) && memcmp(magic, indexMagic, sizeof(magic)) == 0 &&
+              reader.read(&version) && version == LIBRARY_INDEX_VERSION && reader.read(&count);
+
+    std::vector<IndexEntry> entries;
+    if (ok) {
+        // The count comes from the file; a damaged one must not turn into a huge allocation, so
+        // reserve no more than the remaining bytes could hold with every string empty.
+        const size_t minRecordBytes = 4 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(int64_t) + 3 * sizeof(int32_t) +
+                                      sizeof(float) + sizeof(uint64_t);
+        entries.reserve(std::min<size_t>(count, static_cast<size_t>(reader.end - reader.pos) / minRecordBytes));
+        for (uint32_t i = 0; i < count && ok; ++i) {
+            IndexEntry entry;
+            int32_t year, sampleRate, channels;
+            ok = reader.readString(&entry.path) && reader.read(&entry.size) && reader.read(&entry.mtime) &&
+                 reader.readString(&entry.info.title) && reader.readString(&entry.info.artist) &&
+                 reader.readString(&entry.info.album) && reader.read(&year) && reader.read(&entry.info.duration) &&
+                 reader.read(&sampleRate) && reader.read(&channels) && reader.read(&entry.info.artHash);
+            entry.info.year = year;
+            entry.info.sampleRate = sampleRate;
+            entry.info.channels = channels;
+            entries.push_back(std::move(entry));
+        }
+    }
+    UnmapFile(&mapped);
+
+    if (!ok) {
+        std::cerr << "Ignoring unreadable library index: " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    indexEntries = std::move(entries);
+    indexLookup.clear();
+    indexLookup.reserve(indexEntries.size());
+    for (size_t i = 0; i < indexEntries.size(); ++i) {
+        indexLookup[indexEntries[i].path] = i;
+    }
+    indexDirty = false;
+    std::cerr << "Library index loaded: " << indexEntries.size() << " tracks" << std::endl;
+    return true;
+}
+
+bool SaveLibraryIndex() {
+    std::string path = GetLibraryIndexPath();
+    if (path.empty()) return false;
+
+    IndexWriter writer;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!indexDirty) return true;
+
+        writer.bytes.reserve(64 + indexEntries.size() * 256);
+        writer.write(indexMagic);
+        writer.write(static_cast<uint32_t>(LIBRARY_INDEX_VERSION));
+        writer.write(static_cast<uint32_t>(indexEntries.size()));
+        for (const IndexEntry& entry : indexEntries) {
+            writer.writeString(entry.path);
+            writer.write(entry.size);
+            writer.write(entry.mtime);
+            writer.writeString(entry.info.title);
+            writer.writeString(entry.info.artist);
+            writer.writeString(entry.info.album);
+            writer.write(static_cast<int32_t>(entry.info.year));
+            writer.write(entry.info.duration);
+            writer.write(static_cast<int32_t>(entry.info.sampleRate));
+            writer.write(static_cast<int32_t>(entry.info.channels));
+            writer.write(entry.info.artHash);
+        }
+        indexDirty = false;
+    }
+
+    // Write to a temporary file and swap it in, so a crash never leaves a half-written index.
+    std::filesystem::path target = std::filesystem::u8path(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(target.parent_path(), ec);
+
+#ifdef _WIN32
+    FILE* file = _wfopen(temp.c_str(), L"wb");
+#else
+    FILE* file = fopen(temp.c_str(), "wb");
+#endif
+    if (!file) {
+        std::cerr << "Failed to write library index: " << path << std::endl;
+        return false;
+    }
+    size_t written = fwrite(writer.bytes.data(), 1, writer.bytes.size(), file);
+    fclose(file);
+    if (written != writer.bytes.size()) {
+        std::cerr << "Failed to write library index: " << path << std::endl;
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        std::cerr << "Failed to replace library index: " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool LookupLibraryIndex(const std::string& path, uint64_t size, int64_t mtime, TrackInfo* info) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto it = indexLookup.find(path);
+    if (it == indexLookup.end()) return false;
+    const IndexEntry& entry = indexEntries[it->second];
+    if (entry.size != size || entry.mtime != mtime) return false;
+    *info = entry.info;
+    return true;
+}
+
+void UpdateLibraryIndex(const std::string& path, uint64_t size, int64_t mtime, const TrackInfo& info) {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto it = indexLookup.find(path);
+    IndexEntry* entry;
+    if (it != indexLookup.end()) {
+        entry = &indexEntries[it->second];
+    } else {
+        indexLookup[path] = indexEntries.size();
+        indexEntries.emplace_back();
+        entry = &indexEntries.back();
+        entry->path = path;
+    }
+    entry->size = size;
+    entry->mtime = mtime;
+    entry->info = info;
+    entry->info.picture.clear();
+    entry->info.picture.shrink_to_fit();
+    indexDirty = true;
+}
+
+std::vector<IndexEntry> GetLibraryIndexEntries() {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return indexEntries;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "tagRead.h"
+
+#define LIBRARY_INDEX_VERSION 1
+
+// One track as stored in the on-disk index. info.picture is never stored, only info.artHash.
+struct IndexEntry {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    TrackInfo info;
+};
+
+std::string GetLibraryIndexPath();
+bool LoadLibraryIndex();
+bool SaveLibraryIndex();
+
+bool StatTrackFile(const std::string& path, uint64_t* size, int64_t* mtime);
+
+// Both are safe to call from scanner workers. Lookup only succeeds if size and mtime still match.
+bool LookupLibraryIndex(const std::string& path, uint64_t size, int64_t mtime, TrackInfo* info);
+void UpdateLibraryIndex(const std::string& path, uint64_t size, int64_t mtime, const TrackInfo& info);
+
+std::vector<IndexEntry> GetLibraryIndexEntries();
+
+#endif // LIBRARYINDEX_H
\ No newline at end of file
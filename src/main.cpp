@@ -6,6 +6,13 @@
 #include <string>
 #include <algorithm>
 #include "playmusic.h"
+#include "audioEngine.h"
+#include "pcmCache.h"
+#include "decoderPool.h"
+#include "wavExport.h"
+#include "scanner.h"
+#include "frameScheduler.h"
+#include "libraryIndex.h"
 #include "tagRead.h"
 #include <SOIL/SOIL.h>
 #include "albumArt.h"
@@ -24,33 +31,120 @@
 
 int AppState::selectedTab = 0;
 
-void LoadTrack(AppState& state, const std::string& path) {
-    state.audioFilePath = path;
-    CleanupOpenAL();
-    if (!InitOpenAL() || !LoadMP3File(path.c_str(), &buffer)) {
-        state.isLoaded = false;
-        return;
+void InitializeRemainingTracks(AppState& state);
+
+// Shows the tags and cover of the current track. A cover that has to be read from the file is
+// requested from the scan workers and its texture is created when the result arrives.
+void SetTrackDisplay(AppState& state, const TrackInfo& info, GLuint texture) {
+    state.albumArtTexture = texture;
+    state.albumArtHash = info.artHash;
+    TrimCoverArtCache(state.albumArtCache, { state.albumArtHash, state.albumArtHash2 });
+
+    state.title = info.title;
+    state.artist = info.artist;
+    state.album = info.album;
+    state.year = info.year;
+}
+
+void ShowTrackInfo(AppState& state, const std::string& path) {
+    // A known track whose cover texture is still resident needs no file access at all.
+    TrackInfo info;
+    GLuint texture = 0;
+    auto known = state.trackInfos.find(path);
+    if (known != state.trackInfos.end()) {
+        info = known->second;
+        if (info.artHash != 0) texture = FindCoverArt(state.albumArtCache, info.artHash);
+    }
+    if (known == state.trackInfos.end() || (info.artHash != 0 && texture == 0)) {
+        RequestTrackProbe(path);
+    }
+    SetTrackDisplay(state, info, texture);
+
+    state.currentTime = 0.0f;
+
+    auto length = state.trackLengths.find(path);
+    state.trackLength = length != state.trackLengths.end() ? length->second : 0.0f;
+}
+
+// Stores a RequestTrackProbe result; the texture is only built if the track is still the current one.
+void ApplyDisplayProbe(AppState& state, ScanResult& result) {
+    if (result.info.duration > 0.0f && state.trackLengths.find(result.path) == state.trackLengths.end()) {
+        state.trackLengths[result.path] = result.info.duration;
+        if (result.path == state.audioFilePath) state.trackLength = result.info.duration;
+    }
+    TrackInfo& stored = state.trackInfos[result.path];
+    stored = result.info;
+    stored.picture.clear();
+
+    if (result.path != state.audioFilePath) return;
+    GLuint texture = AcquireCoverArt(state.albumArtCache, result.info.artHash, result.info.picture);
+    SetTrackDisplay(state, stored, texture);
+}
+
+// Durations come from the engine once per track; a later DurationUpdated replaces a header estimate.
+void StoreTrackLength(AppState& state, const EngineEvent& event, bool replace) {
+    if (event.duration <= 0.0f) return;
+    if (replace || state.trackLengths.find(event.path) == state.trackLengths.end()) {
+        state.trackLengths[event.path] = event.duration;
+    }
+    if (event.path == state.audioFilePath) {
+        state.trackLength = state.trackLengths[event.path];
+    }
+}
+
+// The track the engine should pre-decode for a gapless transition, or "" when playback stops after this one.
+std::string PeekNextTrack(AppState& state) {
+    if (state.mp3Files.empty()) return "";
+    if (state.isRepeat) return state.audioFilePath;
+
+    if (state.isShuffle) {
+        if (state.remainingTracks.empty()) InitializeRemainingTracks(state);
+        return state.remainingTracks.back();
+    }
+    auto it = std::find(state.mp3Files.begin(), state.mp3Files.end(), state.selectedFile);
+    if (it != state.mp3Files.end() && it + 1 != state.mp3Files.end()) {
+        return *(it + 1);
     }
+    return "";
+}
 
-    alSourcei(source, AL_BUFFER, buffer);
-    alSourcef(source, AL_GAIN, state.volume);
-    ReadMP3Tags(path.c_str(), &state.title, &state.artist, &state.album, &state.year);
+// Only a change is sent; scan batches arrive every frame and mostly leave the next track as it was.
+void QueueNextTrack(AppState& state) {
+    if (!state.isLoaded) return;
+    std::string next = PeekNextTrack(state);
+    if (next == state.queuedNextTrack) return;
+    state.queuedNextTrack = next;
+    EngineSetNext(next);
+}
 
-    std::string imagePath = path.substr(0, path.size() - 4) + ".png";
-    extractCoverArt(path, imagePath);
-    state.albumArtTexture = LoadTextureFromFile(imagePath.c_str());
+void LoadTrack(AppState& state, const std::string& path) {
+    state.audioFilePath = path;
+    EngineLoad(path);
+    ShowTrackInfo(state, path);
     state.isLoaded = true;
-    state.currentTime = 0.0f;
+    QueueNextTrack(state);
+}
+
+// Called when the engine has moved on to the pre-decoded next track without a reload.
+void OnTrackChanged(AppState& state, const std::string& path) {
+    if (state.isShuffle) {
+        auto it = std::find(state.remainingTracks.begin(), state.remainingTracks.end(), path);
+        if (it != state.remainingTracks.end()) state.remainingTracks.erase(it);
+    }
+    state.selectedFile = path;
+    state.audioFilePath = path;
+    ShowTrackInfo(state, path);
+    // The engine forgets its next track once it has moved on to it.
+    state.queuedNextTrack.clear();
+    QueueNextTrack(state);
 }
 
 void TogglePlayPause(AppState& state) {
-    ALint stateAL;
-    alGetSourcei(source, AL_SOURCE_STATE, &stateAL);
-    if (stateAL == AL_PLAYING) {
-        alSourcePause(source);
+    if (state.isPlaying) {
+        EnginePause();
         state.isPlaying = false;
     } else {
-        alSourcePlay(source);
+        EnginePlay();
         state.isPlaying = true;
     }
 }
@@ -76,7 +170,7 @@ void PlayNextTrack(AppState& state) {
         } else return;
     }
     LoadTrack(state, state.selectedFile);
-    alSourcePlay(source);
+    EnginePlay();
     state.isPlaying = true;
 }
 
@@ -94,39 +188,60 @@ void PlayPreviousTrack(AppState& state) {
         } else return;
     }
     LoadTrack(state, state.selectedFile);
-    alSourcePlay(source);
+    EnginePlay();
     state.isPlaying = true;
 }
 
 void AddMP3FromDirectory(AppState& state, const std::string& directory) {
-    try {
-        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
-            if (entry.path().extension() == ".mp3") {
-                std::string path = entry.path().u8string(); 
-                if (std::find(state.mp3Files.begin(), state.mp3Files.end(), path) == state.mp3Files.end()) {
-                    state.mp3Files.push_back(path);
-                    
-                    std::string title, artist, album;
-                    int year;
-                    ReadMP3Tags(path.c_str(), &title, &artist, &album, &year);
-                    std::string imagePath = path.substr(0, path.size() - 4) + ".png";
-                    extractCoverArt(path, imagePath);
-                }
-            }
+    StartLibraryScan(directory);
+}
+
+// Appends a track and its list label once; returns false if the path is already in the library.
+bool AddTrackToLibrary(AppState& state, const std::string& path) {
+    if (!state.mp3FileSet.insert(path).second) return false;
+    state.mp3Files.push_back(path);
+    state.displayNames.push_back(std::filesystem::u8path(path).filename().u8string());
+    return true;
+}
+
+// Rebuilds the track list from the on-disk index without touching the files themselves.
+void RestoreLibrary(AppState& state) {
+    if (!LoadLibraryIndex()) return;
+    for (IndexEntry& entry : GetLibraryIndexEntries()) {
+        if (!AddTrackToLibrary(state, entry.path)) continue;
+        if (entry.info.duration > 0.0f) {
+            state.trackLengths[entry.path] = entry.info.duration;
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        std::cerr << "Filesystem error: " << e.what() << std::endl;
+        state.trackInfos[entry.path] = std::move(entry.info);
     }
 }
 
+// Moves finished probes from the scanner workers into the library, a batch per frame.
+void ApplyScanResults(AppState& state) {
+    static std::vector<ScanResult> batch;
+    if (!PollScanResults(batch)) return;
+
+    std::sort(batch.begin(), batch.end(), [](const ScanResult& a, const ScanResult& b) { return a.path < b.path; });
+    for (ScanResult& result : batch) {
+        if (result.forDisplay) {
+            ApplyDisplayProbe(state, result);
+            continue;
+        }
+        if (!AddTrackToLibrary(state, result.path)) continue;
+        if (result.info.duration > 0.0f && state.trackLengths.find(result.path) == state.trackLengths.end()) {
+            state.trackLengths[result.path] = result.info.duration;
+        }
+        state.trackInfos[result.path] = std::move(result.info);
+    }
+    QueueNextTrack(state);
+}
+
 void AddMP3File(AppState& state, const std::string& filePath) {
     try {
         std::filesystem::path path(filePath);
         if (path.extension() == ".mp3") {
             std::string pathStr = path.u8string();
-            if (std::find(state.mp3Files.begin(), state.mp3Files.end(), pathStr) == state.mp3Files.end()) {
-                state.mp3Files.push_back(pathStr);
-            }
+            AddTrackToLibrary(state, pathStr);
         }
     } catch (const std::filesystem::filesystem_error& e) {
         std::cerr << "Filesystem error: " << e.what() << std::endl;
@@ -135,17 +250,85 @@ void AddMP3File(AppState& state, const std::string& filePath) {
 
 
 
+// Engine and scanner results are handled every loop iteration, including ones that draw nothing.
+void ProcessBackgroundUpdates(AppState& state) {
+    ApplyScanResults(state);
+
+    EngineEvent event;
+    while (PollEngineEvent(event)) {
+        if (event.type == EngineEventType::LoadFailed && event.path == state.audioFilePath) {
+            state.isLoaded = false;
+            state.isPlaying = false;
+        } else if (event.type == EngineEventType::DeviceLost) {
+            state.isPlaying = false;
+        } else if (event.type == EngineEventType::Loaded) {
+            StoreTrackLength(state, event, false);
+        } else if (event.type == EngineEventType::TrackChanged) {
+            OnTrackChanged(state, event.path);
+            StoreTrackLength(state, event, false);
+        } else if (event.type == EngineEventType::DurationUpdated) {
+            StoreTrackLength(state, event, true);
+        } else if (event.type == EngineEventType::TrackEnded && event.path == state.audioFilePath) {
+            if (state.isRepeat) {
+                EngineSeek(0.0f);
+                EnginePlay();
+            } else {
+                state.isPlaying = false;
+                PlayNextTrack(state);
+            }
+        }
+    }
+}
+
+// Only the rows inside the visible scroll range are submitted, so cost does not grow with the library.
+void DrawTrackList(AppState& state, const ImVec2& selectableSize, bool playOnSelect) {
+    ImGui::PushStyleColor(ImGuiCol_Header, IM_COL32(100, 150, 255, 200));
+    ImGui::PushStyleColor(ImGuiCol_HeaderHovered, IM_COL32(120, 180, 255, 255));
+    ImGui::PushStyleColor(ImGuiCol_TextSelectedBg, IM_COL32(80, 130, 230, 255));
+    ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 8.0f);
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(state.mp3Files.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            ImGui::PushID(i);
+            if (ImGui::Selectable(state.displayNames[i].c_str(), state.selectedFile == state.mp3Files[i], 0, selectableSize)) {
+                state.selectedFile = state.mp3Files[i];
+                LoadTrack(state, state.selectedFile);
+                if (playOnSelect) {
+                    EnginePlay();
+                    state.isPlaying = true;
+                }
+            }
+            ImGui::PopID();
+
+            ImVec2 min = ImGui::GetItemRectMin();
+            ImVec2 max = ImGui::GetItemRectMax();
+            drawList->AddLine(ImVec2(min.x, max.y), ImVec2(min.x + selectableSize.x, max.y), IM_COL32(100, 100, 100, 80), 1.0f);
+        }
+    }
+    clipper.End();
+
+    ImGui::PopStyleVar();
+    ImGui::PopStyleColor(3);
+}
+
 void glfw_error_callback(int error, const char* description) {
     fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
-int main(int, char**) {
+int main(int argc, char** argv) {
     std::setlocale(LC_ALL, "en_US.UTF-8"); 
 #ifdef _WIN32
     
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
 #endif
+    // Batch export runs headless and exits without opening a window.
+    if (argc > 1 && std::string(argv[1]) == "--export-wav") {
+        return RunWavExport(argc - 2, argv + 2);
+    }
     AppState state;
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
@@ -161,6 +344,7 @@ int main(int, char**) {
         return 1;
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1);
+    InstallFrameSchedulerCallbacks(window);
 
     
     IMGUI_CHECKVERSION();
@@ -199,10 +383,14 @@ int main(int, char**) {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
-    if (!InitOpenAL()) {
+    InitDecoderPool();
+    SetEngineEventNotifier(RequestFrame);
+    if (!StartAudioEngine()) {
         fprintf(stderr, "Failed to initialize OpenAL\n");
         return 1;
     }
+    EngineSetVolume(state.volume);
+    RestoreLibrary(state);
 
     
     ImVec2 albumArtSize2 = ImVec2(80, 80);
@@ -210,7 +398,10 @@ int main(int, char**) {
     ImVec2 selectableSize(400, 0);
 
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        WaitForNextFrame(window, state.isPlaying, scanProgress.running);
+        ProcessBackgroundUpdates(state);
+        if (!ShouldRenderFrame(window)) continue;
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -256,20 +447,26 @@ int main(int, char**) {
         ImGui::SameLine(405);
         ImGui::BeginGroup();
         if (ImGui::VSliderFloat("##Volume", ImVec2(25, 150), &state.volume, 0.0f, 1.0f, "")) {
-            alSourcef(source, AL_GAIN, state.volume);
+            EngineSetVolume(state.volume);
+        }
+        // Right-click the volume slider for the crossfade between consecutive tracks.
+        if (ImGui::BeginPopupContextItem("##Crossfade")) {
+            static const char* curves[] = {"Linear", "Equal power", "S-curve"};
+            bool changed = ImGui::SliderFloat("Crossfade", &state.crossfadeSeconds, 0.0f, CROSSFADE_MAX_SECONDS, "%.1f s");
+            changed |= ImGui::Combo("Curve", &state.crossfadeCurve, curves, IM_ARRAYSIZE(curves));
+            if (changed) {
+                EngineSetCrossfade(state.crossfadeSeconds, static_cast<CrossfadeCurve>(state.crossfadeCurve));
+            }
+            ImGui::EndPopup();
         }
         ImGui::EndGroup();
 
         ImGui::Spacing();
         
         
-        float trackLength = state.isLoaded ? GetTrackLength(state.audioFilePath) : 0.0f;
-        if (state.isLoaded) {
-            ALint state_al;
-            alGetSourcei(source, AL_SOURCE_STATE, &state_al);
-            if (state_al == AL_PLAYING) {
-                alGetSourcef(source, AL_SEC_OFFSET, &state.currentTime);
-            }
+        float trackLength = state.isLoaded ? state.trackLength : 0.0f;
+        if (state.isLoaded && engineStatus.playing) {
+            state.currentTime = static_cast<float>(engineStatus.clock.seconds());
         }
         int slidePosX = ImGui::GetCursorPosX();
         int slidePosY = ImGui::GetCursorPosY();
@@ -279,7 +476,7 @@ int main(int, char**) {
         ImGui::PushItemWidth(425);
         if (ImGui::SliderFloat("##Track Position", &state.currentTime, 0.0f, trackLength, "Time: %.1f s")) {
             if (state.isLoaded && std::abs(state.currentTime - state.previousTime) > 0.01f) {
-                alSourcef(source, AL_SEC_OFFSET, state.currentTime);
+                EngineSeek(state.currentTime);
                 state.previousTime = state.currentTime;
             }
         }
@@ -310,6 +507,7 @@ int main(int, char**) {
         }
         if (ImGui::Button(u8"\uf01e", ImVec2(30, 30))) {
             state.isRepeat = !state.isRepeat;
+            QueueNextTrack(state);
         }
         ImGui::PopStyleColor();
 
@@ -321,25 +519,13 @@ int main(int, char**) {
         }
         if (ImGui::Button(u8"\uf074", ImVec2(30, 30))) {
             state.isShuffle = !state.isShuffle;
+            QueueNextTrack(state);
         }
         ImGui::PopStyleColor();
         ImGui::PopFont();
         ImGui::PopStyleVar();
 
         
-        if (state.isLoaded) {
-            ALint state_al;
-            alGetSourcei(source, AL_SOURCE_STATE, &state_al);
-            if (state_al == AL_STOPPED) {
-                if (state.isRepeat) {
-                    alSourcePlay(source);
-                } else {
-                    PlayNextTrack(state);
-                }
-            }
-        }
-
-        
         ImGui::SetCursorPosY(ImGui::GetWindowHeight() - 170);
         if (ImGui::Button("Choose File", ImVec2(100, 30))) {
             std::string selectedFile = OpenFileDialog();
@@ -358,37 +544,38 @@ int main(int, char**) {
         }
         ImGui::SameLine();
         if(ImGui::Button("Update echoa-prem chunk", ImVec2(200, 30))) {
-            std::string imagePath = state.audioFilePath.substr(0, state.audioFilePath.size() - 4) + ".png";
-            state.albumArtTexture2 = LoadTextureFromFile(imagePath.c_str());
+            state.albumArtTexture2 = state.albumArtTexture;
+            state.albumArtHash2 = state.albumArtHash;
             state.needToRefresh = true;
         }
 
         
-        if (!state.mp3Files.empty()) {
-            ImGui::Text("MP3 Files:");
-            for (size_t i = 0; i < state.mp3Files.size(); ++i) {
-                std::string fileName = std::filesystem::path(state.mp3Files[i]).filename().string();
-
-                ImGui::PushStyleColor(ImGuiCol_Header, IM_COL32(100, 150, 255, 200));
-                ImGui::PushStyleColor(ImGuiCol_HeaderHovered, IM_COL32(120, 180, 255, 255));
-                ImGui::PushStyleColor(ImGuiCol_TextSelectedBg, IM_COL32(80, 130, 230, 255));
-                ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 8.0f);
+        if (scanProgress.running) {
+            int found = scanProgress.found;
+            int scanned = scanProgress.scanned;
+            char progressText[64];
+            snprintf(progressText, sizeof(progressText), "Scanning %d / %d", scanned, found);
+            ImGui::ProgressBar(found > 0 ? static_cast<float>(scanned) / found : 0.0f, ImVec2(425, 0), progressText);
+        }
 
-                if (ImGui::Selectable(fileName.c_str(), state.selectedFile == state.mp3Files[i], 0, selectableSize)) {
-                    state.selectedFile = state.mp3Files[i];
-                    LoadTrack(state, state.selectedFile);
+        PcmCacheStats cacheStats = GetPcmCacheStats();
+        if (cacheStats.hits + cacheStats.misses > 0) {
+            ImGui::TextDisabled("PCM cache: %llu hits, %llu misses, %zu tracks, %.0f / %.0f MB",
+                                static_cast<unsigned long long>(cacheStats.hits),
+                                static_cast<unsigned long long>(cacheStats.misses), cacheStats.entries,
+                                cacheStats.usedBytes / (1024.0 * 1024.0), cacheStats.budgetBytes / (1024.0 * 1024.0));
+            // Right-click the cache line to change its memory budget.
+            if (ImGui::BeginPopupContextItem("##PcmCache")) {
+                if (ImGui::SliderInt("Cache budget", &state.pcmCacheBudgetMB, 32, 2048, "%d MB")) {
+                    SetPcmCacheBudget(static_cast<size_t>(state.pcmCacheBudgetMB) * 1024 * 1024);
                 }
-
-                ImGui::PopStyleVar();
-                ImGui::PopStyleColor(3);
-
-                
-                ImVec2 min = ImGui::GetItemRectMin();
-                ImVec2 max = ImGui::GetItemRectMax();
-                ImVec2 lineStart = ImVec2(min.x, max.y);
-                ImVec2 lineEnd = ImVec2(min.x + selectableSize.x, max.y);
-                ImGui::GetWindowDrawList()->AddLine(lineStart, lineEnd, IM_COL32(100, 100, 100, 80), 1.0f);
+                ImGui::EndPopup();
             }
+        }
+
+        if (!state.mp3Files.empty()) {
+            ImGui::Text("MP3 Files:");
+            DrawTrackList(state, selectableSize, false);
         } else {
             ImGui::Text("No MP3 files found.");
         }
@@ -437,10 +624,10 @@ int main(int, char**) {
             style.ItemSpacing.y = originalItemSpacingY;
             ImGui::PushItemWidth(600);
             ImGui::SetCursorPos(ImVec2(slideposx2, slideposy2));
-            float trackLength = state.isLoaded ? GetTrackLength(state.audioFilePath) : 0.0f;
+            float trackLength = state.isLoaded ? state.trackLength : 0.0f;
             if (ImGui::SliderFloat("##Track Position", &state.currentTime, 0.0f, trackLength, "Time: %.1f s")) {
                 if (state.isLoaded && std::abs(state.currentTime - state.previousTime) > 0.01f) {
-                    alSourcef(source, AL_SEC_OFFSET, state.currentTime);
+                    EngineSeek(state.currentTime);
                     state.previousTime = state.currentTime;
                 }
             }
@@ -469,6 +656,7 @@ int main(int, char**) {
             }
             if (ImGui::Button(u8"\uf01e", ImVec2(30, 30))) {
                 state.isRepeat = !state.isRepeat;
+                QueueNextTrack(state);
             }
             ImGui::PopStyleColor();
 
@@ -480,6 +668,7 @@ int main(int, char**) {
             }
             if (ImGui::Button(u8"\uf074", ImVec2(30, 30))) {
                 state.isShuffle = !state.isShuffle;
+                QueueNextTrack(state);
             }
             ImGui::PopStyleColor();
             ImGui::PopFont();
@@ -520,7 +709,7 @@ int main(int, char**) {
                         AddMP3File(state, selectedFile);
                         state.selectedFile = selectedFile;
                         LoadTrack(state, selectedFile);
-                        alSourcePlay(source);
+                        EnginePlay();
                         state.isPlaying = true;
                     }
                 }
@@ -536,29 +725,7 @@ int main(int, char**) {
                 ImGui::SetCursorPosY(starttablocaleY);
 
                 if (!state.mp3Files.empty()) {
-                    for (size_t i = 0; i < state.mp3Files.size(); ++i) {
-                        std::string fileName = std::filesystem::path(state.mp3Files[i]).filename().string();
-
-                        ImGui::PushStyleColor(ImGuiCol_Header, IM_COL32(100, 150, 255, 200));
-                        ImGui::PushStyleColor(ImGuiCol_HeaderHovered, IM_COL32(120, 180, 255, 255));
-                        ImGui::PushStyleColor(ImGuiCol_TextSelectedBg, IM_COL32(80, 130, 230, 255));
-                        ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 8.0f);
-
-                        if (ImGui::Selectable(fileName.c_str(), state.selectedFile == state.mp3Files[i], 0, selectableSize)) {
-                            state.selectedFile = state.mp3Files[i];
-                            LoadTrack(state, state.selectedFile);
-                            alSourcePlay(source);
-                            state.isPlaying = true;
-                        }
-                        ImGui::PopStyleColor(3);
-                        ImGui::PopStyleVar();
-
-                        ImVec2 min = ImGui::GetItemRectMin();
-                        ImVec2 max = ImGui::GetItemRectMax();
-                        ImVec2 lineStart = ImVec2(min.x, max.y);
-                        ImVec2 lineEnd = ImVec2(min.x + selectableSize.x, max.y);
-                        ImGui::GetWindowDrawList()->AddLine(lineStart, lineEnd, IM_COL32(100, 100, 100, 80), 1.0f);
-                    }
+                    DrawTrackList(state, selectableSize, true);
                 }
                 ImGui::EndTabItem();
             }
@@ -584,9 +751,14 @@ int main(int, char**) {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         glfwSwapBuffers(window);
+        FrameRendered(ImGui::IsAnyItemActive());
     }
 
-    CleanupOpenAL();
+    StopLibraryScan();
+    SaveLibraryIndex();
+    StopAudioEngine();
+    ShutdownDecoderPool();
+    ClearCoverArtCache(state.albumArtCache);
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
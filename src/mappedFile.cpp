@@ -0,0 +1,96 @@
+#include "mappedFile.h"
+#include <filesystem>
+#include <memory>
+#if defined(_WIN32) && _WIN32_WINNT < 0x0602
+#error "PrefetchFile needs PrefetchVirtualMemory: build with _WIN32_WINNT >= 0x0602"
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MapFile(const std::string& path, MappedFile* mapped) {
+#ifdef _WIN32
+    mapped->file = CreateFileW(std::filesystem::u8path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mapped->file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0) {
+        CloseHandle(mapped->file);
+        return false;
+    }
+    mapped->size = static_cast<size_t>(size.QuadPart);
+    mapped->mapping = CreateFileMappingW(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapped->mapping) {
+        CloseHandle(mapped->file);
+        return false;
+    }
+    mapped->data = static_cast<const unsigned char*>(MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped->data) {
+        CloseHandle(mapped->mapping);
+        CloseHandle(mapped->file);
+        return false;
+    }
+#else
+    mapped->fd = open(path.c_str(), O_RDONLY);
+    if (mapped->fd < 0) return false;
+    struct stat st;
+    if (fstat(mapped->fd, &st) != 0 || st.st_size == 0) {
+        close(mapped->fd);
+        return false;
+    }
+    mapped->size = static_cast<size_t>(st.st_size);
+    void* data = mmap(NULL, mapped->size, PROT_READ, MAP_PRIVATE, mapped->fd, 0);
+    if (data == MAP_FAILED) {
+        close(mapped->fd);
+        return false;
+    }
+    madvise(data, mapped->size, MADV_SEQUENTIAL);
+    mapped->data = static_cast<const unsigned char*>(data);
+#endif
+    return true;
+}
+
+void UnmapFile(MappedFile* mapped) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapped->data);
+    CloseHandle(mapped->mapping);
+    CloseHandle(mapped->file);
+#else
+    munmap(const_cast<unsigned char*>(mapped->data), mapped->size);
+    close(mapped->fd);
+#endif
+    *mapped = MappedFile();
+}
+
+#ifdef _WIN32
+// Runs on a Windows thread-pool thread; mapping, prefetching and unmapping all block on the file.
+static void CALLBACK PrefetchCallback(PTP_CALLBACK_INSTANCE, PVOID context) {
+    std::unique_ptr<std::string> path(static_cast<std::string*>(context));
+    MappedFile mapped;
+    if (!MapFile(*path, &mapped)) return;
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<unsigned char*>(mapped.data);
+    range.NumberOfBytes = mapped.size;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    UnmapFile(&mapped);
+}
+#endif
+
+void PrefetchFile(const std::string& path) {
+#ifdef _WIN32
+    // Windows has no fadvise; prefetching a temporary view leaves the pages in the standby cache.
+    // That happens on the system thread pool so the caller never waits for the disk.
+    std::string* context = new std::string(path);
+    if (!TrySubmitThreadpoolCallback(PrefetchCallback, context, nullptr)) delete context;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+#ifdef POSIX_FADV_WILLNEED
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    close(fd);
+#endif
+}
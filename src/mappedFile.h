@@ -0,0 +1,29 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Read-only view of a whole file, mapped for sequential access. Readers work straight from the mapping.
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+// path is UTF-8. Fails for missing or empty files.
+bool MapFile(const std::string& path, MappedFile* mapped);
+void UnmapFile(MappedFile* mapped);
+
+// Asks the OS to start reading the file into the page cache without waiting for it.
+void PrefetchFile(const std::string& path);
+
+#endif // MAPPEDFILE_H
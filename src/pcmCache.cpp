@@ -0,0 +1,173 @@
+#include "pcmCache.h"
+#include "libraryIndex.h"
+#include "playmusic.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+struct PcmCacheEntry {
+    std::shared_ptr<const DecodedTrack> track;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    size_t bytes = 0;
+    std::list<std::string>::iterator lruPos;
+};
+
+static std::mutex cacheMutex;
+static std::condition_variable decodeCv;
+static std::list<std::string> lru;
+static std::unordered_map<std::string, PcmCacheEntry> entries;
+static size_t budgetBytes = PCM_CACHE_BUDGET;
+static size_t usedBytes = 0;
+static uint64_t hits = 0;
+static uint64_t misses = 0;
+
+static std::deque<std::string> pendingDecodes;
+static std::thread decodeThread;
+static bool decodeStopping = false;
+
+static void EraseEntry(std::unordered_map<std::string, PcmCacheEntry>::iterator it) {
+    usedBytes -= it->second.bytes;
+    lru.erase(it->second.lruPos);
+    entries.erase(it);
+}
+
+static void TrimLocked() {
+    while (usedBytes > budgetBytes && !lru.empty()) {
+        EraseEntry(entries.find(lru.back()));
+    }
+}
+
+static bool IsCachedLocked(const std::string& path, uint64_t size, int64_t mtime) {
+    auto it = entries.find(path);
+    if (it == entries.end()) return false;
+    if (it->second.size == size && it->second.mtime == mtime) return true;
+    EraseEntry(it);
+    return false;
+}
+
+static void InsertLocked(const std::string& path, uint64_t size, int64_t mtime, std::shared_ptr<const DecodedTrack> track) {
+    lru.push_front(path);
+    PcmCacheEntry& entry = entries[path];
+    entry.bytes = track->pcm.size();
+    entry.track = std::move(track);
+    entry.size = size;
+    entry.mtime = mtime;
+    entry.lruPos = lru.begin();
+    usedBytes += entry.bytes;
+    TrimLocked();
+}
+
+static void DecodeWorkerMain() {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    while (true) {
+        decodeCv.wait(lock, [] { return decodeStopping || !pendingDecodes.empty(); });
+        if (decodeStopping) return;
+
+        std::string path = std::move(pendingDecodes.front());
+        pendingDecodes.pop_front();
+        size_t maxBytes = budgetBytes / 2;
+        lock.unlock();
+
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        auto track = std::make_shared<DecodedTrack>();
+        bool ok = StatTrackFile(path, &size, &mtime) && DecodeTrack(path.c_str(), maxBytes, track.get());
+
+        lock.lock();
+        if (!ok || decodeStopping || IsCachedLocked(path, size, mtime)) continue;
+        InsertLocked(path, size, mtime, std::move(track));
+    }
+}
+
+std::shared_ptr<const DecodedTrack> FindDecodedTrack(const std::string& path, bool countMiss) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    bool statOk = StatTrackFile(path, &size, &mtime);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!statOk || !IsCachedLocked(path, size, mtime)) {
+        if (countMiss) ++misses;
+        return nullptr;
+    }
+    PcmCacheEntry& entry = entries[path];
+    lru.splice(lru.begin(), lru, entry.lruPos);
+    ++hits;
+    return entry.track;
+}
+
+void RequestTrackDecode(const std::string& path) {
+    if (path.empty()) return;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (entries.count(path) != 0) return;
+    for (const std::string& pending : pendingDecodes) {
+        if (pending == path) return;
+    }
+    pendingDecodes.push_back(path);
+    if (!decodeThread.joinable()) {
+        decodeStopping = false;
+        decodeThread = std::thread(DecodeWorkerMain);
+    }
+    decodeCv.notify_one();
+}
+
+void StoreDecodedTrack(const std::string& path, std::shared_ptr<const DecodedTrack> track) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!StatTrackFile(path, &size, &mtime)) return;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (track->pcm.size() > budgetBytes / 2 || IsCachedLocked(path, size, mtime)) return;
+    InsertLocked(path, size, mtime, std::move(track));
+}
+
+void ReservePcmCacheBytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    usedBytes += bytes;
+    TrimLocked();
+}
+
+void ReleasePcmCacheBytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    usedBytes -= std::min(bytes, usedBytes);
+}
+
+size_t GetPcmCacheTrackLimit() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return budgetBytes / 2;
+}
+
+void SetPcmCacheBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    budgetBytes = bytes;
+    TrimLocked();
+}
+
+PcmCacheStats GetPcmCacheStats() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    PcmCacheStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.usedBytes = usedBytes;
+    stats.budgetBytes = budgetBytes;
+    stats.entries = entries.size();
+    return stats;
+}
+
+void ClearPcmCache() {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        decodeStopping = true;
+        pendingDecodes.clear();
+    }
+    decodeCv.notify_all();
+    if (decodeThread.joinable()) decodeThread.join();
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+    lru.clear();
+    usedBytes = 0;
+}
@@ -0,0 +1,72 @@
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define PCM_CACHE_BUDGET (256u * 1024u * 1024u)
+
+// Leaves new elements uninitialized on resize, so a decode buffer sized for a whole track is not
+// zero-filled before mpg123_read overwrites it.
+template <typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+    using std::allocator<T>::allocator;
+
+    template <typename U>
+    void construct(U* p) noexcept {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+using PcmBuffer = std::vector<unsigned char, DefaultInitAllocator<unsigned char>>;
+
+// A whole track decoded exactly like the stream decoder would (gapless-trimmed, interleaved).
+struct DecodedTrack {
+    long rate = 0;
+    int channels = 0;
+    int encoding = 0;
+    PcmBuffer pcm;
+};
+
+struct PcmCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t usedBytes = 0;
+    size_t budgetBytes = 0;
+    size_t entries = 0;
+};
+
+// Recently played and upcoming tracks, keyed by path and only valid while size and mtime match.
+// All functions are thread-safe. Entries are shared, so eviction never pulls PCM from under a reader.
+// countMiss is false for speculative lookups, such as preparing the next track, so only tracks
+// actually started count as misses.
+std::shared_ptr<const DecodedTrack> FindDecodedTrack(const std::string& path, bool countMiss = true);
+// Queues a background decode of path unless it is already cached or queued.
+void RequestTrackDecode(const std::string& path);
+// Adds a track whose PCM was collected elsewhere, e.g. from the stream as it played.
+void StoreDecodedTrack(const std::string& path, std::shared_ptr<const DecodedTrack> track);
+// Counts memory held for the cache outside its entries, such as a capture in progress, against the
+// budget; reserving evicts entries to make room.
+void ReservePcmCacheBytes(size_t bytes);
+void ReleasePcmCacheBytes(size_t bytes);
+// A single track may take at most half the budget, so one long file cannot flush everything else.
+size_t GetPcmCacheTrackLimit();
+void SetPcmCacheBudget(size_t bytes);
+PcmCacheStats GetPcmCacheStats();
+// Stops the decode worker and drops every entry.
+void ClearPcmCache();
+
+#endif // PCMCACHE_H
@@ -0,0 +1,126 @@
+#ifndef PCMRING_H
+#define PCMRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+
+// Single-producer/single-consumer ring of interleaved PCM frames. The producer only moves
+// writeIndex and the consumer only moves readIndex, each on its own cache line, so neither side
+// ever waits on the other. Spans hand out the largest contiguous region without copying; the
+// indices count frames since the last reset and wrap through the power-of-two capacity.
+class PcmRing {
+public:
+    struct Span {
+        unsigned char* data = nullptr;
+        size_t frames = 0;
+    };
+
+    // Allocates room for at least minFrames frames and empties the ring. Neither side may
+    // be using the ring while this or clear() runs.
+    void reset(size_t minFrames, size_t bytesPerFrame) {
+        size_t frames = 1;
+        while (frames < minFrames) frames <<= 1;
+        if (frames * bytesPerFrame != frameCount * frameSize) {
+            storage.reset(new (std::align_val_t(RING_ALIGNMENT)) unsigned char[frames * bytesPerFrame]);
+        }
+        frameCount = frames;
+        frameSize = bytesPerFrame;
+        clear();
+    }
+
+    void clear() {
+        writeIndex.store(0, std::memory_order_relaxed);
+        readIndex.store(0, std::memory_order_relaxed);
+        underrunCount.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return frameCount; }
+    size_t frameBytes() const { return frameSize; }
+
+    // Frames buffered right now; exact on either side, a snapshot from any other thread.
+    size_t fill() const {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+    size_t space() const { return frameCount - fill(); }
+
+    // Total frames the consumer has taken since the last reset.
+    uint64_t framesRead() const { return readIndex.load(std::memory_order_acquire); }
+
+    // Number of times the consumer asked for more frames than were buffered.
+    uint64_t underruns() const { return underrunCount.load(std::memory_order_relaxed); }
+    void countUnderrun() { underrunCount.fetch_add(1, std::memory_order_relaxed); }
+
+    // Producer side: free frames starting at the write position, up to the end of the storage.
+    Span writeSpan() {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        size_t free = frameCount - (head - readIndex.load(std::memory_order_acquire));
+        size_t offset = head & (frameCount - 1);
+        return Span{storage.get() + offset * frameSize, std::min(free, frameCount - offset)};
+    }
+
+    void commitWrite(size_t frames) {
+        writeIndex.store(writeIndex.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+    }
+
+    // Consumer side: buffered frames starting at the read position, up to the end of the storage.
+    Span readSpan() {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        size_t available = writeIndex.load(std::memory_order_acquire) - tail;
+        size_t offset = tail & (frameCount - 1);
+        return Span{storage.get() + offset * frameSize, std::min(available, frameCount - offset)};
+    }
+
+    void commitRead(size_t frames) {
+        readIndex.store(readIndex.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+    }
+
+    // Copying helpers over the spans; both return the number of frames moved.
+    size_t write(const void* frames, size_t count) {
+        const unsigned char* src = static_cast<const unsigned char*>(frames);
+        size_t done = 0;
+        while (done < count) {
+            Span span = writeSpan();
+            size_t n = std::min(span.frames, count - done);
+            if (n == 0) break;
+            memcpy(span.data, src + done * frameSize, n * frameSize);
+            commitWrite(n);
+            done += n;
+        }
+        return done;
+    }
+
+    size_t read(void* frames, size_t count) {
+        unsigned char* dst = static_cast<unsigned char*>(frames);
+        size_t done = 0;
+        while (done < count) {
+            Span span = readSpan();
+            size_t n = std::min(span.frames, count - done);
+            if (n == 0) break;
+            memcpy(dst + done * frameSize, span.data, n * frameSize);
+            commitRead(n);
+            done += n;
+        }
+        return done;
+    }
+
+private:
+    static constexpr size_t RING_ALIGNMENT = 64;
+
+    struct AlignedDelete {
+        void operator()(unsigned char* p) const { ::operator delete[](p, std::align_val_t(RING_ALIGNMENT)); }
+    };
+
+    std::unique_ptr<unsigned char[], AlignedDelete> storage;
+    size_t frameCount = 0;
+    size_t frameSize = 0;
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+    alignas(64) std::atomic<uint64_t> underrunCount{0};
+};
+
+#endif // PCMRING_H
@@ -0,0 +1,63 @@
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Playback position published by the engine thread as a sample count plus output latency, stamped
+// with the steady clock. Readers extrapolate from the stamp, so the UI can move the seek bar smoothly
+// every frame without touching OpenAL. Writes use a sequence lock; there must be only one writer.
+class PlaybackClock {
+public:
+    void publish(int64_t samplePosition, int64_t outputLatencyNs, int64_t sampleRate, bool isRunning) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        samples.store(samplePosition, std::memory_order_relaxed);
+        latencyNs.store(outputLatencyNs, std::memory_order_relaxed);
+        rate.store(sampleRate, std::memory_order_relaxed);
+        stampNs.store(NowNs(), std::memory_order_relaxed);
+        running.store(isRunning, std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Seconds of the current track that have reached the speakers by now.
+    double seconds() const {
+        int64_t s, latency, r, stamp;
+        bool isRunning;
+        uint32_t seq;
+        do {
+            seq = sequence.load(std::memory_order_acquire);
+            s = samples.load(std::memory_order_relaxed);
+            latency = latencyNs.load(std::memory_order_relaxed);
+            r = rate.load(std::memory_order_relaxed);
+            stamp = stampNs.load(std::memory_order_relaxed);
+            isRunning = running.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != sequence.load(std::memory_order_relaxed));
+
+        if (r <= 0) return 0.0;
+        // Latency is taken off in both states so pausing and resuming don't make the position jump.
+        double position = static_cast<double>(s) / static_cast<double>(r) - static_cast<double>(latency) * 1e-9;
+        if (isRunning) {
+            position += static_cast<double>(NowNs() - stamp) * 1e-9;
+        }
+        return position > 0.0 ? position : 0.0;
+    }
+
+private:
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<int64_t> samples{0};
+    std::atomic<int64_t> latencyNs{0};
+    std::atomic<int64_t> rate{0};
+    std::atomic<int64_t> stampNs{0};
+    std::atomic<bool> running{false};
+};
+
+#endif // PLAYBACKCLOCK_H
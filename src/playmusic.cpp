@@ -1,17 +1,135 @@
 #include "playmusic.h"
+#include "seekIndex.h"
+#include "mappedFile.h"
+#include "decoderPool.h"
+#include "sampleConvert.h"
+#include "pcmRing.h"
 #include <iostream>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
 #include <vector>
-#ifdef _WIN32
-#include <codecvt>
-#include <locale>
-#endif
 
 ALCdevice* device;
 ALCcontext* context;
 ALuint buffer, source;
+AudioStream stream;
+
+// Sources and buffers are generated once and recycled, so a track change only swaps buffer data.
+static std::vector<ALuint> freeSources;
+static std::vector<ALuint> freeBuffers;
+
+static std::atomic<unsigned> pendingAudioEvents{0};
+static void (*audioEventWake)() = nullptr;
+static bool audioEventsEnabled = false;
+static LPALGETSOURCEI64VSOFT getSourcei64v = nullptr;
+static bool floatDecode = true;
+static bool floatOutput = false;
+static LPALBUFFERCALLBACKSOFT bufferCallback = nullptr;
+static LPALCRENDERSAMPLESSOFT renderSamples = nullptr;
+static bool callbackOutputEnabled = true;
+static float crossfadeSeconds = 0.0f;
+static CrossfadeCurve crossfadeCurve = CrossfadeCurve::EqualPower;
+
+// Decoded frames waiting for the mixer in callback mode; the engine thread produces and OpenAL's
+// mixer thread consumes. callbackEof marks that nothing more will be written before the next reset.
+static PcmRing callbackRing;
+static std::atomic<bool> callbackEof{false};
+static uint64_t reportedUnderruns = 0;
+
+static void DropCapture(bool decodeLater);
+
+// Runs on OpenAL's event thread, so it only records what happened and wakes the engine thread.
+static void AL_APIENTRY OnAudioEvent(ALenum eventType, ALuint object, ALuint param,
+                                     ALsizei, const ALchar*, void*) AL_API_NOEXCEPT17 {
+    unsigned bits = 0;
+    if (eventType == AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT && object == source) {
+        bits = AUDIO_EVENT_BUFFER_COMPLETED;
+    } else if (eventType == AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT && object == source && param == AL_STOPPED) {
+        bits = AUDIO_EVENT_SOURCE_STOPPED;
+    } else if (eventType == AL_EVENT_TYPE_DISCONNECTED_SOFT) {
+        bits = AUDIO_EVENT_DISCONNECTED;
+    }
+    if (bits == 0) return;
+    pendingAudioEvents.fetch_or(bits);
+    if (audioEventWake) audioEventWake();
+}
+
+// Runs on OpenAL's mixer thread every update. It must not call into AL or take a lock; the engine
+// wake only sets a flag and posts a semaphore.
+static ALsizei AL_APIENTRY OnBufferCallback(ALvoid*, ALvoid* sampledata, ALsizei numbytes) AL_API_NOEXCEPT17 {
+    size_t frameBytes = callbackRing.frameBytes();
+    size_t wanted = static_cast<size_t>(numbytes) / frameBytes;
+    size_t got = callbackRing.read(sampledata, wanted);
+
+    bool eof = callbackEof.load(std::memory_order_acquire);
+    if (got < wanted) {
+        // Returning short stops the source, so only do that once the stream has really ended.
+        if (eof) return static_cast<ALsizei>(got * frameBytes);
+        memset(static_cast<unsigned char*>(sampledata) + got * frameBytes, 0, (wanted - got) * frameBytes);
+        callbackRing.countUnderrun();
+    }
+    if (!eof && callbackRing.fill() < callbackRing.capacity() / 2) {
+        pendingAudioEvents.fetch_or(AUDIO_EVENT_BUFFER_COMPLETED);
+        if (audioEventWake) audioEventWake();
+    }
+    return numbytes;
+}
+
+static bool EnableAudioEvents() {
+    if (!alIsExtensionPresent("AL_SOFT_events")) return false;
+
+    auto eventControl = reinterpret_cast<LPALEVENTCONTROLSOFT>(alGetProcAddress("alEventControlSOFT"));
+    auto eventCallback = reinterpret_cast<LPALEVENTCALLBACKSOFT>(alGetProcAddress("alEventCallbackSOFT"));
+    if (!eventControl || !eventCallback) return false;
+
+    const ALenum types[] = {
+        AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT,
+        AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT,
+        AL_EVENT_TYPE_DISCONNECTED_SOFT,
+    };
+    eventCallback(OnAudioEvent, nullptr);
+    eventControl(3, types, AL_TRUE);
+    return alGetError() == AL_NO_ERROR;
+}
+
+// Makes context current and sets up what playback needs on it: the source and buffer pools and
+// the extension entry points. Cleans up and fails if the context cannot be made current.
+static bool SetupContext() {
+    if (!alcMakeContextCurrent(context)) {
+        std::cerr << "Failed to make OpenAL context current" << std::endl;
+        alcDestroyContext(context);
+        alcCloseDevice(device);
+        context = nullptr;
+        device = nullptr;
+        return false;
+    }
+
+    freeSources.resize(SOURCE_POOL_SIZE);
+    alGenSources(SOURCE_POOL_SIZE, freeSources.data());
+    freeBuffers.resize(BUFFER_POOL_SIZE);
+    alGenBuffers(BUFFER_POOL_SIZE, freeBuffers.data());
+
+    source = AcquireSource();
+    AcquireBuffers(1, &buffer);
+
+    if (alIsExtensionPresent("AL_SOFT_source_latency")) {
+        getSourcei64v = reinterpret_cast<LPALGETSOURCEI64VSOFT>(alGetProcAddress("alGetSourcei64vSOFT"));
+    }
+    floatOutput = alIsExtensionPresent("AL_EXT_FLOAT32") != AL_FALSE;
+    if (alIsExtensionPresent("AL_SOFT_callback_buffer")) {
+        bufferCallback = reinterpret_cast<LPALBUFFERCALLBACKSOFT>(alGetProcAddress("alBufferCallbackSOFT"));
+    }
+    return true;
+}
+
+bool InitOpenAL(void (*wake)()) {
+    if (device && context) {
+        return true;
+    }
+    audioEventWake = wake;
 
-bool InitOpenAL() {
     device = alcOpenDevice(NULL);
     if (!device) {
         std::cerr << "Failed to open OpenAL device" << std::endl;
@@ -19,148 +137,953 @@ bool InitOpenAL() {
     }
 
     context = alcCreateContext(device, NULL);
-    if (!alcMakeContextCurrent(context)) {
-        std::cerr << "Failed to make OpenAL context current" << std::endl;
+    if (!SetupContext()) {
         return false;
     }
 
-    alGenBuffers(1, &buffer);
-    alGenSources(1, &source);
+    audioEventsEnabled = EnableAudioEvents();
+    if (!audioEventsEnabled) {
+        std::cerr << "AL_SOFT_events not available, polling source state" << std::endl;
+    }
     return true;
 }
 
+bool InitOpenALLoopback(ALCint rate) {
+    if (device && context) {
+        return true;
+    }
+    if (!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback")) {
+        std::cerr << "ALC_SOFT_loopback not available" << std::endl;
+        return false;
+    }
+    auto loopbackOpenDevice = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT"));
+    renderSamples = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(alcGetProcAddress(NULL, "alcRenderSamplesSOFT"));
+    device = loopbackOpenDevice ? loopbackOpenDevice(NULL) : nullptr;
+    if (!device || !renderSamples) {
+        std::cerr << "Failed to open OpenAL loopback device" << std::endl;
+        if (device) alcCloseDevice(device);
+        device = nullptr;
+        renderSamples = nullptr;
+        return false;
+    }
+
+    // Float output skips the device's dither; HRTF and the limiter are off so the mix only depends
+    // on the source data and the library version.
+    const ALCint attributes[] = {
+        ALC_FREQUENCY, rate,
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_HRTF_SOFT, ALC_FALSE,
+        ALC_OUTPUT_LIMITER_SOFT, ALC_FALSE,
+        0,
+    };
+    context = alcCreateContext(device, attributes);
+    if (!context) {
+        std::cerr << "Failed to create OpenAL loopback context" << std::endl;
+        alcCloseDevice(device);
+        device = nullptr;
+        renderSamples = nullptr;
+        return false;
+    }
+    // Nothing runs the mixer on its own, so there are no events to wait for.
+    return SetupContext();
+}
+
+void RenderLoopback(float* out, ALCsizei frames) {
+    renderSamples(device, out, frames);
+}
+
+void SetFloatDecode(bool enabled) {
+    floatDecode = enabled;
+}
+
+void SetCallbackOutput(bool enabled) {
+    callbackOutputEnabled = enabled;
+}
+
+void SetCrossfade(float seconds, CrossfadeCurve curve) {
+    crossfadeSeconds = std::min(std::max(seconds, 0.0f), CROSSFADE_MAX_SECONDS);
+    crossfadeCurve = curve;
+}
+
+float GetCrossfadeSeconds() {
+    return crossfadeSeconds;
+}
+
+bool HasAudioEvents() {
+    return audioEventsEnabled;
+}
+
+unsigned TakeAudioEvents() {
+    return pendingAudioEvents.exchange(0);
+}
+
+bool IsOutputConnected() {
+    if (!device || !alcIsExtensionPresent(device, "ALC_EXT_disconnect")) return true;
+    ALCint connected = ALC_TRUE;
+    alcGetIntegerv(device, ALC_CONNECTED, 1, &connected);
+    return connected != ALC_FALSE;
+}
+
+bool ReopenOutputDevice() {
+    if (!device || !alcIsExtensionPresent(device, "ALC_SOFT_reopen_device")) return false;
+    auto reopenDevice = reinterpret_cast<LPALCREOPENDEVICESOFT>(alcGetProcAddress(device, "alcReopenDeviceSOFT"));
+    return reopenDevice && reopenDevice(device, nullptr, nullptr);
+}
+
 void CleanupOpenAL() {
-    alDeleteSources(1, &source);
-    alDeleteBuffers(1, &buffer);
+    if (!device) return;
+
+    if (audioEventsEnabled) {
+        auto eventCallback = reinterpret_cast<LPALEVENTCALLBACKSOFT>(alGetProcAddress("alEventCallbackSOFT"));
+        eventCallback(nullptr, nullptr);
+        audioEventsEnabled = false;
+    }
+    // Shutting down: an unfinished capture is not worth a background decode.
+    DropCapture(false);
+    CloseStream();
+    getSourcei64v = nullptr;
+    bufferCallback = nullptr;
+    renderSamples = nullptr;
+    ReleaseBuffers(1, &buffer);
+    ReleaseSource(source);
+    buffer = 0;
+    source = 0;
+
+    alDeleteSources(static_cast<ALsizei>(freeSources.size()), freeSources.data());
+    alDeleteBuffers(static_cast<ALsizei>(freeBuffers.size()), freeBuffers.data());
+    freeSources.clear();
+    freeBuffers.clear();
+
     alcMakeContextCurrent(NULL);
     alcDestroyContext(context);
     alcCloseDevice(device);
+    context = nullptr;
+    device = nullptr;
 }
 
-bool LoadMP3File(const char* filename, ALuint* buffer) {
-    if (!filename || strlen(filename) == 0) {
-        std::cerr << "Error: File path is empty or null." << std::endl;
-        return false;
+ALuint AcquireSource() {
+    ALuint src = 0;
+    if (freeSources.empty()) {
+        alGenSources(1, &src);
+        return src;
+    }
+    src = freeSources.back();
+    freeSources.pop_back();
+    return src;
+}
+
+void ReleaseSource(ALuint src) {
+    if (src == 0) return;
+    alSourceRewind(src);
+    alSourcei(src, AL_BUFFER, 0);
+    freeSources.push_back(src);
+}
+
+void AcquireBuffers(ALsizei count, ALuint* out) {
+    for (ALsizei i = 0; i < count; ++i) {
+        if (freeBuffers.empty()) {
+            alGenBuffers(1, &out[i]);
+        } else {
+            out[i] = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+    }
+}
+
+void ReleaseBuffers(ALsizei count, const ALuint* buffers) {
+    for (ALsizei i = 0; i < count; ++i) {
+        if (buffers[i] != 0) freeBuffers.push_back(buffers[i]);
+    }
+}
+
+// mpg123 reads through a memory-mapped view instead of read() calls, so a decode or a full
+// mpg123_scan costs page faults on a sequential mapping rather than one syscall per block.
+struct MappedReader {
+    MappedFile file;
+    int64_t pos = 0;
+    // When set, reads fail once it turns true; mpg123 reads once per frame, so a scan stops within a frame.
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+static int ReadMapped(void* handle, void* buf, size_t count, size_t* got) {
+    MappedReader* reader = static_cast<MappedReader*>(handle);
+    if (reader->cancel && reader->cancel->load(std::memory_order_relaxed)) {
+        *got = 0;
+        return -1;
+    }
+    size_t available = reader->file.size - static_cast<size_t>(reader->pos);
+    *got = std::min(count, available);
+    memcpy(buf, reader->file.data + reader->pos, *got);
+    reader->pos += *got;
+    return 0;
+}
+
+static int64_t SeekMapped(void* handle, int64_t offset, int whence) {
+    MappedReader* reader = static_cast<MappedReader*>(handle);
+    int64_t base = whence == SEEK_CUR ? reader->pos : whence == SEEK_END ? static_cast<int64_t>(reader->file.size) : 0;
+    int64_t target = base + offset;
+    if (target < 0 || target > static_cast<int64_t>(reader->file.size)) return -1;
+    reader->pos = target;
+    return target;
+}
+
+static void CloseMapped(void* handle) {
+    MappedReader* reader = static_cast<MappedReader*>(handle);
+    UnmapFile(&reader->file);
+    delete reader;
+}
+
+static int OpenMpg123(mpg123_handle* mh, const char* filename, const std::atomic<bool>* cancel = nullptr) {
+    MappedReader* reader = new MappedReader;
+    reader->cancel = cancel;
+    if (!MapFile(filename, &reader->file)) {
+        delete reader;
+        // A pooled handle may still carry the mapped reader from its previous file.
+        mpg123_replace_reader(mh, NULL, NULL);
+        return mpg123_open(mh, filename);
     }
+    if (mpg123_reader64(mh, ReadMapped, SeekMapped, CloseMapped) != MPG123_OK) {
+        CloseMapped(reader);
+        mpg123_replace_reader(mh, NULL, NULL);
+        return mpg123_open(mh, filename);
+    }
+    // From here on mpg123_close owns the reader, including when the open itself fails.
+    return mpg123_open_handle(mh, reader);
+}
+
+// Decodes the rest of the track into pcm. The buffer is sized once from mpg123_length, left
+// uninitialized and filled by mpg123_read in place; it only grows if the header underestimated the length.
+static void DecodeWholeTrack(mpg123_handle* mh, size_t frameBytes, PcmBuffer* pcm) {
+    size_t block = mpg123_outblock(mh);
+    off_t totalSamples = mpg123_length(mh);
+    size_t expected = totalSamples > 0 ? static_cast<size_t>(totalSamples) * frameBytes : 0;
+
+    pcm->resize(expected + block);
+    size_t filled = 0;
+    while (true) {
+        if (pcm->size() - filled < block) {
+            pcm->resize(pcm->size() + std::max(block, pcm->size() / 4));
+        }
+        size_t done = 0;
+        int err = mpg123_read(mh, pcm->data() + filled, pcm->size() - filled, &done);
+        filled += done;
+        if (err != MPG123_OK && err != MPG123_NEW_FORMAT) break;
+    }
+    pcm->resize(filled);
+}
 
-    std::cerr << "Attempting to load MP3 file: " << filename << std::endl;
+// Length in seconds as reported by the decoder. It is taken from the Xing/VBRI/LAME header when the
+// file has one; otherwise it is an estimate from the first frame's bitrate and *accurate is false.
+static float GetDecoderLength(mpg123_handle* mh, long rate, bool* accurate) {
+    long isAccurate = 0;
+    mpg123_getstate(mh, MPG123_ACCURATE, &isAccurate, NULL);
+    if (accurate) *accurate = isAccurate != 0;
+
+    off_t totalSamples = mpg123_length(mh);
+    if (totalSamples <= 0 || rate <= 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(static_cast<double>(totalSamples) / static_cast<double>(rate));
+}
+
+static void CloseMpg123(mpg123_handle*& mh) {
+    if (!mh) return;
+    ReleaseDecoder(mh);
+    mh = nullptr;
+}
+
+float IndexTrack(const std::string& filePath, const std::atomic<bool>* cancel) {
+    mpg123_handle* mh = AcquireDecoder();
+    if (!mh) {
+        return 0.0f;
+    }
+
+    if (OpenMpg123(mh, filePath.c_str(), cancel) != MPG123_OK) {
+        std::cerr << "Failed to open MP3 file: " << filePath << " (" << mpg123_strerror(mh) << ")" << std::endl;
+        CloseMpg123(mh);
+        return 0.0f;
+    }
 
-    mpg123_handle* mh;
-    unsigned char* audio;
-    size_t done;
-    int err;
     long rate;
     int channels, encoding;
+    float trackLength = 0.0f;
+    if (mpg123_getformat(mh, &rate, &channels, &encoding) == MPG123_OK && mpg123_scan(mh) == MPG123_OK) {
+        trackLength = GetDecoderLength(mh, rate, nullptr);
+        SaveSeekIndex(filePath, mh);
+    } else if (!cancel || !cancel->load()) {
+        std::cerr << "Failed to scan MP3 file: " << filePath << std::endl;
+    }
+    CloseMpg123(mh);
+    return trackLength;
+}
 
-    mpg123_init();
-    mh = mpg123_new(NULL, &err);
+// Opens a decoder with gapless trimming and a locked output format. *encoding is the requested
+// sample encoding on input and the one actually locked on output; 16-bit is the fallback.
+static mpg123_handle* OpenStreamDecoder(const char* filename, long* rate, int* channels, int* encoding) {
+    if (!filename || strlen(filename) == 0) {
+        std::cerr << "Error: File path is empty or null." << std::endl;
+        return nullptr;
+    }
+
+    mpg123_handle* mh = AcquireDecoder();
     if (!mh) {
-        std::cerr << "Failed to create mpg123 handle: " << mpg123_plain_strerror(err) << std::endl;
-        mpg123_exit();
-        return false;
+        return nullptr;
     }
 
-#ifdef _WIN32
-    
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-    std::wstring wfilename = converter.from_bytes(filename);
-    if (mpg123_open(mh, converter.to_bytes(wfilename).c_str()) != MPG123_OK) {
-#else
-    if (mpg123_open(mh, filename) != MPG123_OK) {
-#endif
+    if (OpenMpg123(mh, filename) != MPG123_OK) {
         std::cerr << "Failed to open MP3 file: " << filename << " (" << mpg123_strerror(mh) << ")" << std::endl;
-        mpg123_delete(mh);
-        mpg123_exit();
-        return false;
+        CloseMpg123(mh);
+        return nullptr;
     }
+    // With a cached frame index any seek jumps straight to the right file offset.
+    LoadSeekIndex(filename, mh);
 
-    if (mpg123_getformat(mh, &rate, &channels, &encoding) != MPG123_OK) {
+    int nativeEncoding;
+    if (mpg123_getformat(mh, rate, channels, &nativeEncoding) != MPG123_OK || *rate <= 0) {
         std::cerr << "Failed to get MP3 format: " << mpg123_strerror(mh) << std::endl;
-        mpg123_close(mh);
-        mpg123_delete(mh);
-        mpg123_exit();
-        return false;
+        CloseMpg123(mh);
+        return nullptr;
+    }
+
+    // Lock the output format so a mid-stream format change cannot corrupt the queue.
+    mpg123_format_none(mh);
+    if (mpg123_format(mh, *rate, *channels, *encoding) != MPG123_OK) {
+        *encoding = MPG123_ENC_SIGNED_16;
+        mpg123_format(mh, *rate, *channels, *encoding);
     }
+    return mh;
+}
 
-    std::vector<unsigned char> pcmData;
-    size_t buffer_size = mpg123_outblock(mh);
-    audio = (unsigned char*)malloc(buffer_size);
+mpg123_handle* OpenTrackDecoder(const char* filename, long* rate, int* channels, int* encoding) {
+    return OpenStreamDecoder(filename, rate, channels, encoding);
+}
+
+void CloseTrackDecoder(mpg123_handle* mh) {
+    CloseMpg123(mh);
+}
+
+static int PreferredEncoding() {
+    return floatDecode ? MPG123_ENC_FLOAT_32 : MPG123_ENC_SIGNED_16;
+}
+
+// Bytes per frame as decoded.
+static int FrameBytes() {
+    return stream.channels * stream.sampleBytes;
+}
 
-    while (mpg123_read(mh, audio, buffer_size, &done) == MPG123_OK) {
-        pcmData.insert(pcmData.end(), audio, audio + done);
+// Bytes per frame as handed to OpenAL, after any float to int16 conversion.
+static int OutputFrameBytes() {
+    return stream.channels * (stream.convertToInt16 ? 2 : stream.sampleBytes);
+}
+
+bool DecodeTrack(const char* filename, size_t maxBytes, DecodedTrack* track) {
+    track->encoding = PreferredEncoding();
+    mpg123_handle* mh = OpenStreamDecoder(filename, &track->rate, &track->channels, &track->encoding);
+    if (!mh) return false;
+
+    size_t frameBytes = static_cast<size_t>(track->channels) * mpg123_encsize(track->encoding);
+    off_t totalSamples = mpg123_length(mh);
+    bool fits = totalSamples > 0 && static_cast<size_t>(totalSamples) * frameBytes <= maxBytes;
+    if (fits) {
+        DecodeWholeTrack(mh, frameBytes, &track->pcm);
     }
+    CloseMpg123(mh);
+    return fits && !track->pcm.empty();
+}
 
-    free(audio);
-    mpg123_close(mh);
-    mpg123_delete(mh);
-    mpg123_exit();
+// Cached PCM is only usable if it matches the decoder's output format.
+static std::shared_ptr<const DecodedTrack> FindCachedStream(const char* filename, long rate, int channels, int encoding,
+                                                            bool countMiss) {
+    std::shared_ptr<const DecodedTrack> track = FindDecodedTrack(filename, countMiss);
+    if (track && (track->rate != rate || track->channels != channels || track->encoding != encoding)) return nullptr;
+    return track;
+}
 
-    ALenum format;
-    if (channels == 1)
-        format = AL_FORMAT_MONO16;
-    else if (channels == 2)
-        format = AL_FORMAT_STEREO16;
-    else {
-        std::cerr << "Unsupported number of channels: " << channels << std::endl;
+// Ends the capture. With decodeLater, a track left before its end is decoded in the background
+// instead, so coming back to it still finds it cached.
+static void DropCapture(bool decodeLater) {
+    if (decodeLater && stream.capture) RequestTrackDecode(stream.capturePath);
+    stream.capture.reset();
+    stream.captureMh = nullptr;
+    ReleasePcmCacheBytes(stream.captureReserved);
+    stream.captureReserved = 0;
+}
+
+// Adds what mh just decoded to the capture; err is the result of that mpg123_read.
+static void CaptureDecoded(mpg123_handle* mh, const unsigned char* data, size_t bytes, int err) {
+    if (!stream.capture || mh != stream.captureMh) return;
+    PcmBuffer& pcm = stream.capture->pcm;
+    if (pcm.size() + bytes > stream.captureLimit) {
+        DropCapture(false);
+        return;
+    }
+    if (pcm.size() + bytes > stream.captureReserved) {
+        // The header underestimated the length; grow the reservation a quarter at a time.
+        size_t grown = std::min(stream.captureLimit,
+                                std::max(pcm.size() + bytes, stream.captureReserved + stream.captureReserved / 4));
+        ReservePcmCacheBytes(grown - stream.captureReserved);
+        stream.captureReserved = grown;
+        pcm.reserve(grown);
+    }
+    pcm.insert(pcm.end(), data, data + bytes);
+    if (err == MPG123_DONE) {
+        // Hand the reservation back first so storing the track does not evict for it twice.
+        std::shared_ptr<DecodedTrack> track = std::move(stream.capture);
+        DropCapture(false);
+        if (!track->pcm.empty()) StoreDecodedTrack(stream.capturePath, std::move(track));
+    } else if (err != MPG123_OK && err != MPG123_NEW_FORMAT) {
+        DropCapture(false);
+    }
+}
+
+// Closes the outgoing track's decoder. A fade can end on its last sample without the read that
+// reports MPG123_DONE, so a capture still running on it is finished first.
+static void ClosePrevDecoder() {
+    unsigned char tail[4096];
+    while (stream.capture && stream.prevMh && stream.prevMh == stream.captureMh) {
+        size_t done = 0;
+        int err = mpg123_read(stream.prevMh, tail, sizeof(tail), &done);
+        if (done == 0 && err == MPG123_OK) err = MPG123_ERR;
+        CaptureDecoded(stream.prevMh, tail, done, err);
+    }
+    CloseMpg123(stream.prevMh);
+    stream.prevCached.reset();
+}
+
+// Makes the pre-opened next track the active decoder; its samples follow the current track's
+// last sample in the same AL buffer so the transition is sample-contiguous.
+static void SwitchToNextDecoder() {
+    stream.prevMh = stream.mh;
+    stream.mh = stream.nextMh;
+    stream.nextMh = nullptr;
+    stream.trackBoundary = stream.samplesDecoded;
+    stream.pendingPcm.swap(stream.nextPcm);
+    stream.nextPcm.clear();
+    stream.pendingPos = 0;
+    stream.prevCached = std::move(stream.cached);
+    stream.cached = std::move(stream.nextCached);
+    stream.cachedPos = 0;
+    stream.totalSamples = stream.nextTotalSamples;
+}
+
+// Frames the current track should overlap with the prepared next one, or 0 for a gapless switch.
+static int64_t CrossfadeFrames() {
+    if (crossfadeSeconds <= 0.0f || !stream.nextMh || stream.prevMh) return 0;
+    // Wait until the current track is being decoded, not replayed from its pre-decoded start.
+    if (stream.pendingPos < stream.pendingPcm.size() || stream.totalSamples <= 0) return 0;
+    int64_t frames = static_cast<int64_t>(crossfadeSeconds * stream.rate);
+    // Never fade over more than half of either track.
+    frames = std::min(frames, stream.totalSamples / 2);
+    if (stream.nextTotalSamples > 0) frames = std::min(frames, stream.nextTotalSamples / 2);
+    return frames;
+}
+
+// Hands over to the next track early; the old decoder keeps its position for the fade-out.
+static void StartCrossfade(int64_t frames) {
+    size_t cachedPos = stream.cachedPos;
+    SwitchToNextDecoder();
+    stream.prevCachedPos = cachedPos;
+    stream.fadeFrames = frames;
+    stream.fadePos = 0;
+}
+
+// Once the playback position has passed the boundary the old track is only needed for the fade.
+static void EndCrossfade() {
+    stream.fadeFrames = 0;
+    stream.fadePos = 0;
+    if (stream.trackBoundary < 0) {
+        ClosePrevDecoder();
+    }
+}
+
+// Reads the next size bytes of the outgoing track into out, padding with silence past its end.
+static void ReadFadeOut(unsigned char* out, size_t size) {
+    size_t filled = 0;
+    if (stream.prevCached) {
+        const PcmBuffer& pcm = stream.prevCached->pcm;
+        filled = std::min(size, pcm.size() - stream.prevCachedPos);
+        memcpy(out, pcm.data() + stream.prevCachedPos, filled);
+        stream.prevCachedPos += filled;
+    } else if (stream.prevMh) {
+        while (filled < size) {
+            size_t done = 0;
+            int err = mpg123_read(stream.prevMh, out + filled, size - filled, &done);
+            CaptureDecoded(stream.prevMh, out + filled, done, err);
+            filled += done;
+            if (err != MPG123_OK && err != MPG123_NEW_FORMAT) break;
+        }
+    }
+    memset(out + filled, 0, size - filled);
+}
+
+static void CrossfadeGains(float t, float* inGain, float* outGain) {
+    switch (crossfadeCurve) {
+    case CrossfadeCurve::Linear:
+        *inGain = t;
+        *outGain = 1.0f - t;
+        break;
+    case CrossfadeCurve::EqualPower:
+        *inGain = std::sin(t * 1.57079633f);
+        *outGain = std::cos(t * 1.57079633f);
+        break;
+    case CrossfadeCurve::SCurve:
+        *inGain = t * t * (3.0f - 2.0f * t);
+        *outGain = 1.0f - *inGain;
+        break;
+    }
+}
+
+// Mixes the outgoing track under the incoming samples in place and advances the fade.
+static void MixCrossfade(unsigned char* incoming, size_t bytes) {
+    size_t frames = bytes / FrameBytes();
+    stream.fadePcm.resize(bytes);
+    ReadFadeOut(stream.fadePcm.data(), bytes);
+
+    bool isInt16 = stream.encoding != MPG123_ENC_FLOAT_32;
+    size_t count = frames * static_cast<size_t>(stream.channels);
+    float* in = reinterpret_cast<float*>(incoming);
+    const float* out = reinterpret_cast<const float*>(stream.fadePcm.data());
+    if (isInt16) {
+        stream.fadeMix.resize(count * 2);
+        ConvertInt16ToFloat(reinterpret_cast<const int16_t*>(incoming), stream.fadeMix.data(), count);
+        ConvertInt16ToFloat(reinterpret_cast<const int16_t*>(stream.fadePcm.data()), stream.fadeMix.data() + count, count);
+        in = stream.fadeMix.data();
+        out = stream.fadeMix.data() + count;
+    }
+    float length = static_cast<float>(stream.fadeFrames);
+    for (size_t f = 0; f < frames; f += CROSSFADE_RAMP_FRAMES) {
+        size_t n = std::min<size_t>(CROSSFADE_RAMP_FRAMES, frames - f);
+        float inStart, outStart, inEnd, outEnd;
+        CrossfadeGains(static_cast<float>(stream.fadePos + f) / length, &inStart, &outStart);
+        CrossfadeGains(static_cast<float>(stream.fadePos + f + n) / length, &inEnd, &outEnd);
+        size_t offset = f * stream.channels;
+        MixGainRamp(in + offset, out + offset, n, stream.channels, inStart, inEnd, outStart, outEnd);
+    }
+    if (isInt16) {
+        ConvertFloatToInt16(in, reinterpret_cast<int16_t*>(incoming), count, &stream.dither);
+    }
+    stream.fadePos += static_cast<int64_t>(frames);
+    if (stream.fadePos >= stream.fadeFrames) EndCrossfade();
+}
+
+// Fills out with up to size bytes of PCM, returns the number of bytes decoded.
+static size_t DecodeStreamChunk(unsigned char* out, size_t size) {
+    size_t filled = 0;
+    while (filled < size && !stream.eof) {
+        size_t wanted = size - filled;
+        int64_t fadeFrames = CrossfadeFrames();
+        if (fadeFrames > 0) {
+            int64_t remaining = stream.totalSamples - stream.samplesDecoded;
+            if (remaining > fadeFrames) {
+                // Stop exactly where the fade has to begin.
+                wanted = std::min(wanted, static_cast<size_t>(remaining - fadeFrames) * FrameBytes());
+            } else if (remaining > 0) {
+                StartCrossfade(remaining);
+            }
+        }
+        if (stream.fadePos < stream.fadeFrames) {
+            wanted = std::min(wanted, static_cast<size_t>(stream.fadeFrames - stream.fadePos) * FrameBytes());
+        }
+
+        size_t done = 0;
+        int err = MPG123_OK;
+        if (stream.pendingPos < stream.pendingPcm.size()) {
+            done = std::min(wanted, stream.pendingPcm.size() - stream.pendingPos);
+            memcpy(out + filled, stream.pendingPcm.data() + stream.pendingPos, done);
+            stream.pendingPos += done;
+        } else if (stream.cached) {
+            const PcmBuffer& pcm = stream.cached->pcm;
+            done = std::min(wanted, pcm.size() - stream.cachedPos);
+            memcpy(out + filled, pcm.data() + stream.cachedPos, done);
+            stream.cachedPos += done;
+            if (stream.cachedPos == pcm.size()) err = MPG123_DONE;
+        } else {
+            err = mpg123_read(stream.mh, out + filled, wanted, &done);
+            CaptureDecoded(stream.mh, out + filled, done, err);
+        }
+        if (done > 0 && stream.fadePos < stream.fadeFrames) {
+            MixCrossfade(out + filled, done);
+        }
+        filled += done;
+        stream.samplesDecoded += done / FrameBytes();
+
+        if (err != MPG123_OK && err != MPG123_NEW_FORMAT) {
+            if (err != MPG123_DONE) {
+                std::cerr << "Stream decode error: " << mpg123_strerror(stream.mh) << std::endl;
+            }
+            if (stream.nextMh && !stream.prevMh) {
+                SwitchToNextDecoder();
+            } else {
+                stream.eof = true;
+            }
+        }
+    }
+    return filled;
+}
+
+// Converts a decoded chunk to the output format if needed; returns the samples to hand to OpenAL.
+static const void* OutputChunk(size_t bytes, size_t* outBytes) {
+    if (!stream.convertToInt16) {
+        *outBytes = bytes;
+        return stream.chunk.data();
+    }
+    size_t samples = bytes / sizeof(float);
+    ConvertFloatToInt16(reinterpret_cast<const float*>(stream.chunk.data()), stream.converted.data(), samples, &stream.dither);
+    *outBytes = samples * sizeof(int16_t);
+    return stream.converted.data();
+}
+
+static bool FillAndQueue(ALuint buf) {
+    size_t bytes = DecodeStreamChunk(stream.chunk.data(), stream.chunk.size());
+    if (bytes == 0) return false;
+    size_t outBytes;
+    const void* data = OutputChunk(bytes, &outBytes);
+    alBufferData(buf, stream.format, data, static_cast<ALsizei>(outBytes), stream.rate);
+    alSourceQueueBuffers(source, 1, &buf);
+    return true;
+}
+
+// Tops the callback ring up one block at a time, decoding straight into its free space unless the
+// samples need converting first. The last block also tells the mixer that the stream ends there.
+static void FillCallbackRing() {
+    while (!stream.eof && callbackRing.space() >= STREAM_CALLBACK_BLOCK_FRAMES) {
+        PcmRing::Span span = callbackRing.writeSpan();
+        size_t frames = std::min<size_t>(span.frames, STREAM_CALLBACK_BLOCK_FRAMES);
+        size_t bytes;
+        if (stream.convertToInt16) {
+            bytes = DecodeStreamChunk(stream.chunk.data(), frames * FrameBytes());
+            ConvertFloatToInt16(reinterpret_cast<const float*>(stream.chunk.data()), reinterpret_cast<int16_t*>(span.data),
+                                bytes / sizeof(float), &stream.dither);
+        } else {
+            bytes = DecodeStreamChunk(span.data, frames * FrameBytes());
+        }
+        callbackRing.commitWrite(bytes / FrameBytes());
+    }
+    if (stream.eof) callbackEof.store(true, std::memory_order_release);
+}
+
+// Unqueues every buffer from the source, e.g. before a seek or when the stream is closed.
+static void UnqueueAll() {
+    alSourceRewind(source);
+    ALint queued = 0;
+    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+    while (queued-- > 0) {
+        ALuint buf;
+        alSourceUnqueueBuffers(source, 1, &buf);
+    }
+    alSourcei(source, AL_BUFFER, 0);
+}
+
+// Hands the output everything it should hold from the current decode position: the four queued
+// buffers, or a full ring behind a callback buffer. The source must be stopped and empty.
+static void PrimeOutput() {
+    if (!stream.callbackOutput) {
+        for (ALuint buf : stream.buffers) {
+            if (!FillAndQueue(buf)) break;
+        }
+        return;
+    }
+    reportedUnderruns = 0;
+    callbackRing.clear();
+    callbackEof.store(false, std::memory_order_relaxed);
+    FillCallbackRing();
+    bufferCallback(stream.buffers[0], stream.format, static_cast<ALsizei>(stream.rate), OnBufferCallback, nullptr);
+    alSourcei(source, AL_BUFFER, static_cast<ALint>(stream.buffers[0]));
+}
+
+bool OpenStream(const char* filename) {
+    CloseStream();
+
+    stream.encoding = PreferredEncoding();
+    stream.mh = OpenStreamDecoder(filename, &stream.rate, &stream.channels, &stream.encoding);
+    if (!stream.mh) {
         return false;
     }
+    stream.sampleBytes = static_cast<int>(mpg123_encsize(stream.encoding));
 
-    if (rate <= 0) {
-        std::cerr << "Invalid sample rate: " << rate << std::endl;
+    // Float samples go to OpenAL as-is when AL_EXT_FLOAT32 is there, otherwise through a dithered conversion.
+    bool isFloat = stream.encoding == MPG123_ENC_FLOAT_32;
+    stream.convertToInt16 = isFloat && !floatOutput;
+    bool float32Buffers = isFloat && floatOutput;
+    if (stream.channels == 1)
+        stream.format = float32Buffers ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_MONO16;
+    else if (stream.channels == 2)
+        stream.format = float32Buffers ? AL_FORMAT_STEREO_FLOAT32 : AL_FORMAT_STEREO16;
+    else {
+        std::cerr << "Unsupported number of channels: " << stream.channels << std::endl;
+        CloseStream();
         return false;
     }
 
-    alBufferData(*buffer, format, pcmData.data(), pcmData.size(), rate);
+    stream.cached = FindCachedStream(filename, stream.rate, stream.channels, stream.encoding, true);
+    stream.totalSamples = stream.cached ? stream.cached->pcm.size() / FrameBytes() : mpg123_length(stream.mh);
+    if (!stream.cached && stream.totalSamples > 0) {
+        // Playing the track through fills the cache as well, so it is never decoded a second time for it.
+        stream.captureLimit = GetPcmCacheTrackLimit();
+        size_t expected = static_cast<size_t>(stream.totalSamples) * FrameBytes();
+        if (expected <= stream.captureLimit) {
+            stream.capture = std::make_shared<DecodedTrack>();
+            stream.capture->rate = stream.rate;
+            stream.capture->channels = stream.channels;
+            stream.capture->encoding = stream.encoding;
+            ReservePcmCacheBytes(expected);
+            stream.captureReserved = expected;
+            stream.capture->pcm.reserve(expected);
+            stream.captureMh = stream.mh;
+            stream.capturePath = filename;
+        }
+    }
+
+    // With a callback buffer the mixer pulls small blocks as it goes, so a seek or a gain change is
+    // heard within one mixer update instead of after up to a second of queued buffers.
+    stream.callbackOutput = callbackOutputEnabled && bufferCallback != nullptr;
+    size_t chunkBytes = stream.callbackOutput
+        ? static_cast<size_t>(STREAM_CALLBACK_BLOCK_FRAMES) * FrameBytes()
+        : static_cast<size_t>(stream.rate) * FrameBytes() * STREAM_BUFFER_MS / 1000;
+    stream.chunk.resize(chunkBytes);
+    if (stream.convertToInt16) {
+        stream.converted.resize(chunkBytes / sizeof(float));
+    }
+
+    AcquireBuffers(STREAM_BUFFER_COUNT, stream.buffers);
+    UnqueueAll();
+    if (stream.callbackOutput) {
+        // Nothing reads the ring while the source is detached, so it can be resized here.
+        callbackRing.reset(STREAM_CALLBACK_RING_FRAMES, static_cast<size_t>(OutputFrameBytes()));
+    }
+    PrimeOutput();
+
     ALenum error = alGetError();
     if (error != AL_NO_ERROR) {
-        std::cerr << "OpenAL error after setting buffer data: " << error << std::endl;
+        std::cerr << "OpenAL error while queueing stream buffers: " << error << std::endl;
+        CloseStream();
         return false;
     }
 
-    std::cerr << "MP3 file loaded successfully: " << filename << std::endl;
+    std::cerr << "MP3 stream opened: " << filename << std::endl;
     return true;
 }
 
-float GetTrackLength(const std::string& filePath) {
-    mpg123_handle* mh = mpg123_new(NULL, NULL);
-    if (!mh) {
-        std::cerr << "Failed to initialize mpg123" << std::endl;
-        return 0.0f;
+bool PrepareNextStream(const char* filename) {
+    DiscardNextStream();
+    if (!stream.mh) return false;
+
+    long rate;
+    int channels;
+    int encoding = stream.encoding;
+    mpg123_handle* mh = OpenStreamDecoder(filename, &rate, &channels, &encoding);
+    if (!mh) return false;
+
+    // A queue can only hold buffers of one format; anything else falls back to a regular track change.
+    if (rate != stream.rate || channels != stream.channels || encoding != stream.encoding) {
+        std::cerr << "Next track format differs, gapless transition disabled: " << filename << std::endl;
+        CloseMpg123(mh);
+        return false;
     }
 
-#ifdef _WIN32
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-    std::wstring wfilename = converter.from_bytes(filePath);
-    if (mpg123_open(mh, converter.to_bytes(wfilename).c_str()) != MPG123_OK) {
-#else
-    if (mpg123_open(mh, filePath.c_str()) != MPG123_OK) {
-#endif
-        std::cerr << "Failed to open MP3 file: " << filePath << " (" << mpg123_strerror(mh) << ")" << std::endl;
-        mpg123_delete(mh);
-        return 0.0f;
+    stream.nextCached = FindCachedStream(filename, rate, channels, encoding, false);
+    if (stream.nextCached) {
+        stream.nextTotalSamples = stream.nextCached->pcm.size() / FrameBytes();
+        stream.nextMh = mh;
+        return true;
     }
 
-    off_t totalFrames = mpg123_length(mh);
-    if (totalFrames <= 0) {
-        std::cerr << "Failed to get total frames" << std::endl;
-        mpg123_close(mh);
-        mpg123_delete(mh);
-        return 0.0f;
+    stream.nextPcm.resize(stream.chunk.size());
+    size_t filled = 0;
+    while (filled < stream.nextPcm.size()) {
+        size_t done = 0;
+        int err = mpg123_read(mh, stream.nextPcm.data() + filled, stream.nextPcm.size() - filled, &done);
+        filled += done;
+        if (err != MPG123_OK && err != MPG123_NEW_FORMAT) break;
     }
+    stream.nextPcm.resize(filled);
+    stream.nextTotalSamples = mpg123_length(mh);
+    stream.nextMh = mh;
+    return true;
+}
 
-    long rate;
-    int channels, encoding;
-    if (mpg123_getformat(mh, &rate, &channels, &encoding) != MPG123_OK) {
-        std::cerr << "Failed to get MP3 format" << std::endl;
-        mpg123_close(mh);
-        mpg123_delete(mh);
-        return 0.0f;
+void DiscardNextStream() {
+    CloseMpg123(stream.nextMh);
+    stream.nextCached.reset();
+    stream.nextPcm.clear();
+    stream.nextTotalSamples = 0;
+}
+
+bool UpdateStream() {
+    if (!stream.mh) return false;
+    if (stream.callbackOutput) {
+        FillCallbackRing();
+        return !stream.eof;
+    }
+
+    ALint processed = 0;
+    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+    while (processed-- > 0) {
+        ALuint buf;
+        alSourceUnqueueBuffers(source, 1, &buf);
+
+        ALint size = 0;
+        alGetBufferi(buf, AL_SIZE, &size);
+        stream.samplesDone += size / OutputFrameBytes();
+
+        FillAndQueue(buf);
+    }
+    return !stream.eof;
+}
+
+// The source stops by itself when it runs out of queued data; resume it if that was an underrun.
+// In callback mode the mixer pads underruns with silence and the source never stops for one.
+bool RecoverStreamUnderrun() {
+    if (!stream.mh || stream.callbackOutput) return false;
+    ALint state, queued, processed;
+    alGetSourcei(source, AL_SOURCE_STATE, &state);
+    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+    if (state == AL_STOPPED && queued > processed) {
+        alSourcePlay(source);
+        return true;
+    }
+    return false;
+}
+
+int TakeStreamUnderruns() {
+    uint64_t total = callbackRing.underruns();
+    int count = static_cast<int>(total - reportedUnderruns);
+    reportedUnderruns = total;
+    return count;
+}
+
+// Samples played since samplesDone was last advanced.
+static int64_t PlayedSinceSamplesDone() {
+    if (stream.callbackOutput) return static_cast<int64_t>(callbackRing.framesRead());
+    ALint offset = 0;
+    alGetSourcei(source, AL_SAMPLE_OFFSET, &offset);
+    return offset;
+}
+
+bool AdvanceStreamTrack() {
+    if (!stream.prevMh || stream.trackBoundary < 0) return false;
+
+    if (stream.samplesDone + PlayedSinceSamplesDone() < stream.trackBoundary) return false;
+
+    // Rebase the clock so positions are relative to the start of the new track.
+    stream.samplesDone -= stream.trackBoundary;
+    stream.samplesDecoded -= stream.trackBoundary;
+    stream.trackBoundary = -1;
+    // A crossfade still mixing the old track closes it when it finishes.
+    if (stream.fadePos >= stream.fadeFrames) {
+        ClosePrevDecoder();
+    }
+    return true;
+}
+
+bool SeekStream(float seconds) {
+    if (!stream.mh) return false;
+    // The capture has to start at the first sample, so a seek ends it.
+    DropCapture(true);
+
+    // The next track may already be queued behind the current one; seeking stays within the current one.
+    if (stream.prevMh && stream.trackBoundary >= 0) {
+        CloseMpg123(stream.mh);
+        stream.mh = stream.prevMh;
+        stream.prevMh = nullptr;
+        stream.trackBoundary = -1;
+        stream.pendingPcm.clear();
+        stream.pendingPos = 0;
+        stream.cached = std::move(stream.prevCached);
+        stream.totalSamples = stream.cached ? stream.cached->pcm.size() / FrameBytes() : mpg123_length(stream.mh);
     }
+    // A fade-out still running after the track change is dropped along with the queued audio.
+    stream.fadeFrames = 0;
+    stream.fadePos = 0;
+    CloseMpg123(stream.prevMh);
+    stream.prevCached.reset();
 
-    double trackLength = static_cast<double>(totalFrames) / static_cast<double>(rate);
+    ALint state;
+    alGetSourcei(source, AL_SOURCE_STATE, &state);
+    UnqueueAll();
+
+    off_t target;
+    if (stream.cached) {
+        size_t frames = stream.cached->pcm.size() / FrameBytes();
+        target = std::min(static_cast<off_t>(seconds * stream.rate), static_cast<off_t>(frames));
+        stream.cachedPos = static_cast<size_t>(target) * FrameBytes();
+    } else {
+        target = mpg123_seek(stream.mh, static_cast<off_t>(seconds * stream.rate), SEEK_SET);
+    }
+    if (target < 0) {
+        std::cerr << "Failed to seek stream: " << mpg123_strerror(stream.mh) << std::endl;
+        return false;
+    }
+    stream.samplesDone = target;
+    stream.samplesDecoded = target;
+    stream.eof = false;
+
+    PrimeOutput();
+    if (state == AL_PLAYING) {
+        alSourcePlay(source);
+    }
+    return true;
+}
 
-    mpg123_close(mh);
-    mpg123_delete(mh);
+bool ApplyStreamSeekIndex(const std::string& path) {
+    // During a gapless transition the track still audible is decoded by prevMh.
+    mpg123_handle* mh = stream.prevMh && stream.trackBoundary >= 0 ? stream.prevMh : stream.mh;
+    return mh && LoadSeekIndex(path, mh);
+}
+
+void CloseStream() {
+    if (stream.buffers[0] != 0) {
+        UnqueueAll();
+        ReleaseBuffers(STREAM_BUFFER_COUNT, stream.buffers);
+    }
+    CloseMpg123(stream.mh);
+    CloseMpg123(stream.prevMh);
+    CloseMpg123(stream.nextMh);
+    DropCapture(true);
+    stream = AudioStream();
+}
+
+bool IsStreamFinished() {
+    if (!stream.mh || !stream.eof) return false;
+    ALint state, queued;
+    alGetSourcei(source, AL_SOURCE_STATE, &state);
+    if (stream.callbackOutput) {
+        return state == AL_STOPPED && callbackRing.fill() == 0;
+    }
+    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+    ALint processed = 0;
+    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+    return state == AL_STOPPED && queued == processed;
+}
+
+int64_t GetStreamSamplePosition(int64_t* latencyNs) {
+    if (latencyNs) *latencyNs = 0;
+    if (!stream.mh) return 0;
+
+    if (getSourcei64v) {
+        // Offset and latency are sampled together; the offset is 32.32 fixed point.
+        ALint64SOFT values[2] = {0, 0};
+        getSourcei64v(source, AL_SAMPLE_OFFSET_LATENCY_SOFT, values);
+        if (latencyNs) *latencyNs = values[1];
+        // A callback buffer has no fixed length to take an offset into; count what the mixer pulled.
+        if (!stream.callbackOutput) return stream.samplesDone + (values[0] >> 32);
+    }
+    return stream.samplesDone + PlayedSinceSamplesDone();
+}
+
+float GetStreamPosition() {
+    if (!stream.mh || stream.rate <= 0) return 0.0f;
+    return static_cast<float>(static_cast<double>(GetStreamSamplePosition()) / stream.rate);
+}
+
+float GetStreamLength(bool* accurate) {
+    if (!stream.mh) return 0.0f;
+    return GetDecoderLength(stream.mh, stream.rate, accurate);
+}
 
-    return static_cast<float>(trackLength);
+float GetStreamRemaining() {
+    if (!stream.mh || stream.rate <= 0 || stream.totalSamples <= 0) return 0.0f;
+    return static_cast<float>(stream.totalSamples) / stream.rate - GetStreamPosition();
 }
\ No newline at end of file
@@ -3,21 +3,163 @@
 
 #include <al.h>
 #include <alc.h>
+#include <alext.h>
 #include <mpg123.h>
 #include <vector>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib> 
 #include <string>
+#include <memory>
+#include "pcmCache.h"
+#include "sampleConvert.h"
 
-bool InitOpenAL();
+#define SOURCE_POOL_SIZE 2
+#define BUFFER_POOL_SIZE 16
+
+// Bits reported by the AL_SOFT_events callback; see TakeAudioEvents().
+#define AUDIO_EVENT_BUFFER_COMPLETED 0x1u
+#define AUDIO_EVENT_SOURCE_STOPPED 0x2u
+#define AUDIO_EVENT_DISCONNECTED 0x4u
+
+// wake is called on OpenAL's event thread whenever an event arrives, and on its mixer thread when the
+// callback ring runs low; it must not call into AL.
+bool InitOpenAL(void (*wake)() = nullptr);
+
+// Headless alternative to InitOpenAL: an ALC_SOFT_loopback device mixing stereo float at rate,
+// which only advances when RenderLoopback is called. CleanupOpenAL closes it like any other device.
+bool InitOpenALLoopback(ALCint rate);
+// Mixes the next frames of output into out (frames * 2 floats) on the calling thread.
+void RenderLoopback(float* out, ALCsizei frames);
 
 void CleanupOpenAL();
 
-bool LoadMP3File(const char* filename, ALuint* buffer);
-float GetTrackLength(const std::string& filePath);
+// False when the library lacks AL_SOFT_events and the caller has to poll source state instead.
+bool HasAudioEvents();
+// Returns and clears the AUDIO_EVENT_* bits received since the last call.
+unsigned TakeAudioEvents();
+bool IsOutputConnected();
+// Moves the context to the current default device after a disconnect (ALC_SOFT_reopen_device).
+bool ReopenOutputDevice();
+
+ALuint AcquireSource();
+void ReleaseSource(ALuint src);
+void AcquireBuffers(ALsizei count, ALuint* out);
+void ReleaseBuffers(ALsizei count, const ALuint* buffers);
+
+// Decode to 32-bit float (the default) or 16-bit; applies from the next OpenStream.
+void SetFloatDecode(bool enabled);
+// Let OpenAL pull samples through AL_SOFT_callback_buffer (the default) instead of queueing
+// STREAM_BUFFER_MS buffers; applies from the next OpenStream and only where the extension exists.
+void SetCallbackOutput(bool enabled);
+
+// Decodes a whole track into memory with the same settings as the stream decoder; fails without
+// decoding if the track would need more than maxBytes.
+bool DecodeTrack(const char* filename, size_t maxBytes, DecodedTrack* track);
+// Opens a decoder with the stream's gapless and seek-index setup and the output locked to *encoding,
+// falling back to 16-bit like the player does. Close it with CloseTrackDecoder.
+mpg123_handle* OpenTrackDecoder(const char* filename, long* rate, int* channels, int* encoding);
+void CloseTrackDecoder(mpg123_handle* mh);
+// Walks every frame once with mpg123_scan, caches the resulting seek index and returns the exact length.
+// Setting *cancel stops the scan at the next frame; nothing is cached then and 0 is returned.
+float IndexTrack(const std::string& filePath, const std::atomic<bool>* cancel = nullptr);
+
+enum class CrossfadeCurve {
+    Linear,
+    EqualPower,
+    SCurve
+};
+
+#define CROSSFADE_MAX_SECONDS 12.0f
+// Curve gains are exact every this many frames and ramped linearly in between.
+#define CROSSFADE_RAMP_FRAMES 64
+
+// Overlaps the end of each track with the start of the prepared next one, 0 to CROSSFADE_MAX_SECONDS.
+// 0 keeps plain gapless transitions. Call from the thread driving the stream.
+void SetCrossfade(float seconds, CrossfadeCurve curve);
+float GetCrossfadeSeconds();
+
+#define STREAM_BUFFER_COUNT 4
+#define STREAM_BUFFER_MS 250
+#define GAPLESS_PRELOAD_SECONDS 3.0f
+// Callback output: the mixer pulls from a ring of this many frames, refilled in blocks of
+// STREAM_CALLBACK_BLOCK_FRAMES once it drops below half. Both must be powers of two.
+#define STREAM_CALLBACK_RING_FRAMES 8192
+#define STREAM_CALLBACK_BLOCK_FRAMES 1024
+
+struct AudioStream {
+    mpg123_handle* mh = nullptr;
+    mpg123_handle* prevMh = nullptr;
+    mpg123_handle* nextMh = nullptr;
+    ALuint buffers[STREAM_BUFFER_COUNT] = {};
+    ALenum format = 0;
+    // Set when buffers[0] is a callback buffer fed from the ring instead of a queue of all four.
+    bool callbackOutput = false;
+    long rate = 0;
+    int channels = 0;
+    int encoding = MPG123_ENC_SIGNED_16;
+    int sampleBytes = 2;
+    // Set when decoding to float but the device lacks AL_EXT_FLOAT32.
+    bool convertToInt16 = false;
+    std::vector<int16_t> converted;
+    DitherState dither;
+    // Set when the track is in the PCM cache; samples are then copied from it instead of decoded.
+    std::shared_ptr<const DecodedTrack> cached;
+    std::shared_ptr<const DecodedTrack> prevCached;
+    std::shared_ptr<const DecodedTrack> nextCached;
+    size_t cachedPos = 0;
+    // Set while a track opened by OpenStream is decoded from its start without a seek. What
+    // captureMh decodes is collected here and stored in the PCM cache once it reports the end.
+    std::shared_ptr<DecodedTrack> capture;
+    mpg123_handle* captureMh = nullptr;
+    std::string capturePath;
+    size_t captureLimit = 0;
+    // Bytes of the capture buffer counted against the PCM cache budget.
+    size_t captureReserved = 0;
+    std::vector<unsigned char> chunk;
+    std::vector<unsigned char> nextPcm;
+    std::vector<unsigned char> pendingPcm;
+    size_t pendingPos = 0;
+    int64_t totalSamples = 0;
+    int64_t nextTotalSamples = 0;
+    int64_t samplesDone = 0;
+    int64_t samplesDecoded = 0;
+    int64_t trackBoundary = -1;
+    // Crossfade: after the next track takes over, prevMh (or prevCached from prevCachedPos) keeps
+    // decoding the old track's last fadeFrames frames into fadePcm to be mixed under the new one.
+    int64_t fadeFrames = 0;
+    int64_t fadePos = 0;
+    size_t prevCachedPos = 0;
+    std::vector<unsigned char> fadePcm;
+    // 16-bit streams are mixed in float: both tracks' samples, converted, then dithered back.
+    std::vector<float> fadeMix;
+    bool eof = false;
+};
+
+bool OpenStream(const char* filename);
+bool PrepareNextStream(const char* filename);
+void DiscardNextStream();
+bool UpdateStream();
+bool RecoverStreamUnderrun();
+// Returns and clears the number of blocks the mixer had to pad with silence in callback mode.
+int TakeStreamUnderruns();
+bool AdvanceStreamTrack();
+bool SeekStream(float seconds);
+// Installs the cached seek index for path on the decoder currently playing it.
+bool ApplyStreamSeekIndex(const std::string& path);
+void CloseStream();
+bool IsStreamFinished();
+// Track-relative sample position of the source across all queued buffers, plus the output latency
+// in nanoseconds when AL_SOFT_source_latency is available (0 otherwise).
+int64_t GetStreamSamplePosition(int64_t* latencyNs = nullptr);
+float GetStreamPosition();
+float GetStreamLength(bool* accurate);
+float GetStreamRemaining();
 
 extern ALCdevice* device;
 extern ALCcontext* context;
 extern ALuint buffer, source;
+extern AudioStream stream;
 
 #endif // PLAYMUSIC_H
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "sampleConvert.h"
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAMPLECONVERT_SSE2 1
+#endif
+
+static inline uint32_t XorShift(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+// Uniform value in [0, 1) from the top 23 bits, built by filling a float mantissa.
+static inline float UnitFloat(uint32_t x) {
+    uint32_t bits = (x >> 9) | 0x3f800000u;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f - 1.0f;
+}
+
+static void ConvertScalar(const float* in, int16_t* out, size_t count, uint32_t* seed) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t a = XorShift(*seed);
+        uint32_t b = XorShift(a);
+        *seed = b;
+        float value = in[i] * 32767.0f + (UnitFloat(a) - UnitFloat(b));
+        value = std::fmin(std::fmax(value, -32768.0f), 32767.0f);
+        out[i] = static_cast<int16_t>(std::lrint(value));
+    }
+}
+
+#ifdef SAMPLECONVERT_SSE2
+static inline __m128i XorShift4(__m128i x) {
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    return x;
+}
+
+static inline __m128 UnitFloat4(__m128i x) {
+    __m128i bits = _mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3f800000));
+    return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0f));
+}
+#endif
+
+void ConvertFloatToInt16(const float* in, int16_t* out, size_t count, DitherState* dither) {
+    size_t i = 0;
+#ifdef SAMPLECONVERT_SSE2
+    // Eight samples per step: two float vectors, each with its own TPDF noise, packed with saturation.
+    __m128i seeds = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither->seeds));
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = XorShift4(seeds);
+        __m128i b = XorShift4(a);
+        __m128i c = XorShift4(b);
+        seeds = XorShift4(c);
+        __m128 lo = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), _mm_sub_ps(UnitFloat4(a), UnitFloat4(b)));
+        __m128 hi = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), _mm_sub_ps(UnitFloat4(c), UnitFloat4(seeds)));
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither->seeds), seeds);
+#endif
+    ConvertScalar(in + i, out + i, count - i, &dither->seeds[0]);
+}
+
+static void MixGainRampScalar(float* dst, const float* src, size_t first, size_t frames, int channels,
+                              float dstStart, float dstStep, float srcStart, float srcStep) {
+    for (size_t f = first; f < frames; ++f) {
+        float dstGain = dstStart + dstStep * static_cast<float>(f);
+        float srcGain = srcStart + srcStep * static_cast<float>(f);
+        for (int c = 0; c < channels; ++c) {
+            size_t i = f * channels + c;
+            dst[i] = dst[i] * dstGain + src[i] * srcGain;
+        }
+    }
+}
+
+void MixGainRamp(float* dst, const float* src, size_t frames, int channels,
+                 float dstStart, float dstEnd, float srcStart, float srcEnd) {
+    if (frames == 0) return;
+    float dstStep = (dstEnd - dstStart) / static_cast<float>(frames);
+    float srcStep = (srcEnd - srcStart) / static_cast<float>(frames);
+    size_t f = 0;
+#ifdef SAMPLECONVERT_SSE2
+    if (channels == 1 || channels == 2) {
+        // Each vector holds four samples: four mono frames or two stereo frames. The gain for a
+        // sample is start + step * frame, with the frame numbers kept in a vector of their own.
+        size_t framesPerVector = 4 / channels;
+        __m128 frameIndex = channels == 1 ? _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f) : _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+        const __m128 frameAdvance = _mm_set1_ps(static_cast<float>(framesPerVector));
+        const __m128 dstBase = _mm_set1_ps(dstStart), dstSlope = _mm_set1_ps(dstStep);
+        const __m128 srcBase = _mm_set1_ps(srcStart), srcSlope = _mm_set1_ps(srcStep);
+        for (; f + framesPerVector <= frames; f += framesPerVector) {
+            size_t i = f * channels;
+            __m128 dstGain = _mm_add_ps(dstBase, _mm_mul_ps(dstSlope, frameIndex));
+            __m128 srcGain = _mm_add_ps(srcBase, _mm_mul_ps(srcSlope, frameIndex));
+            __m128 mixed = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dst + i), dstGain), _mm_mul_ps(_mm_loadu_ps(src + i), srcGain));
+            _mm_storeu_ps(dst + i, mixed);
+            frameIndex = _mm_add_ps(frameIndex, frameAdvance);
+        }
+    }
+#endif
+    MixGainRampScalar(dst, src, f, frames, channels, dstStart, dstStep, srcStart, srcStep);
+}
+
+void ConvertInt16ToFloat(const int16_t* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef SAMPLECONVERT_H
+#define SAMPLECONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-stream state of the dither noise generator; any non-zero seeds work.
+struct DitherState {
+    uint32_t seeds[4] = { 0x9e3779b9u, 0x7f4a7c15u, 0x85ebca6bu, 0xc2b2ae35u };
+};
+
+// Converts interleaved float samples in [-1, 1] to int16 with TPDF dither of +-1 LSB and saturation.
+// Uses SSE2 where available; out and in may not overlap.
+void ConvertFloatToInt16(const float* in, int16_t* out, size_t count, DitherState* dither);
+
+// Converts int16 samples to float in [-1, 1).
+void ConvertInt16ToFloat(const int16_t* in, float* out, size_t count);
+
+// Mixes src into dst in place for interleaved frames: dst = dst * dstGain + src * srcGain, with each
+// gain moving linearly from its start to its end value across the block. SSE2 for mono and stereo.
+void MixGainRamp(float* dst, const float* src, size_t frames, int channels,
+                 float dstStart, float dstEnd, float srcStart, float srcEnd);
+
+#endif // SAMPLECONVERT_H
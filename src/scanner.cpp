@@ -0,0 +1,190 @@
+#include "scanner.h"
+#include "libraryIndex.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+ScanProgress scanProgress;
+
+static std::mutex scanMutex;
+static std::condition_variable scanCv;
+static std::deque<std::string> pendingDirectories;
+static std::deque<std::string> pendingFiles;
+static std::deque<std::string> pendingProbes;
+static std::vector<std::thread> scanThreads;
+static bool scanStopping = false;
+static bool enumerating = false;
+static int activeProbes = 0;
+
+static std::mutex resultsMutex;
+static std::vector<ScanResult> finishedResults;
+
+static void UpdateRunning() {
+    scanProgress.running = enumerating || activeProbes > 0 || !pendingDirectories.empty() || !pendingFiles.empty();
+}
+
+static void EnumeratorMain() {
+    std::unique_lock<std::mutex> lock(scanMutex);
+    while (true) {
+        scanCv.wait(lock, [] { return scanStopping || !pendingDirectories.empty(); });
+        if (scanStopping) return;
+
+        std::string directory = std::move(pendingDirectories.front());
+        pendingDirectories.pop_front();
+        enumerating = true;
+        lock.unlock();
+
+        // Paths are handed to the workers in small batches to keep lock traffic low.
+        std::vector<std::string> batch;
+        auto flush = [&batch]() {
+            std::lock_guard<std::mutex> guard(scanMutex);
+            for (std::string& path : batch) pendingFiles.push_back(std::move(path));
+            scanProgress.found += static_cast<int>(batch.size());
+            batch.clear();
+            scanCv.notify_all();
+        };
+
+        try {
+            for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+                if (entry.path().extension() == ".mp3") {
+                    batch.push_back(entry.path().u8string());
+                    if (batch.size() >= 64) flush();
+                }
+            }
+        } catch (const std::filesystem::filesystem_error& e) {
+            std::cerr << "Filesystem error: " << e.what() << std::endl;
+        }
+        flush();
+
+        lock.lock();
+        enumerating = false;
+        UpdateRunning();
+    }
+}
+
+// Display probes always open the file: the index does not keep cover images.
+static void ProbeForDisplay(std::unique_lock<std::mutex>& lock) {
+    ScanResult result;
+    result.path = std::move(pendingProbes.front());
+    result.forDisplay = true;
+    pendingProbes.pop_front();
+    lock.unlock();
+
+    ProbeTrack(result.path, &result.info);
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (StatTrackFile(result.path, &size, &mtime)) {
+        TrackInfo indexed = result.info;
+        indexed.picture.clear();
+        UpdateLibraryIndex(result.path, size, mtime, indexed);
+    }
+    {
+        std::lock_guard<std::mutex> guard(resultsMutex);
+        finishedResults.push_back(std::move(result));
+    }
+    lock.lock();
+}
+
+static void WorkerMain() {
+    std::unique_lock<std::mutex> lock(scanMutex);
+    while (true) {
+        scanCv.wait(lock, [] { return scanStopping || !pendingProbes.empty() || !pendingFiles.empty(); });
+        if (scanStopping) return;
+        if (!pendingProbes.empty()) {
+            ProbeForDisplay(lock);
+            continue;
+        }
+
+        ScanResult result;
+        result.path = std::move(pendingFiles.front());
+        pendingFiles.pop_front();
+        ++activeProbes;
+        lock.unlock();
+
+        // Files whose size and mtime match the index are not opened at all.
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        bool statOk = StatTrackFile(result.path, &size, &mtime);
+        if (!statOk || !LookupLibraryIndex(result.path, size, mtime, &result.info)) {
+            ProbeTrack(result.path, &result.info);
+            result.info.picture.clear();
+            result.info.picture.shrink_to_fit();
+            if (statOk) UpdateLibraryIndex(result.path, size, mtime, result.info);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(resultsMutex);
+            finishedResults.push_back(std::move(result));
+        }
+        ++scanProgress.scanned;
+
+        lock.lock();
+        --activeProbes;
+        UpdateRunning();
+        if (!scanProgress.running) {
+            lock.unlock();
+            SaveLibraryIndex();
+            lock.lock();
+        }
+    }
+}
+
+// Called with scanMutex held.
+static void StartScanThreads() {
+    if (!scanThreads.empty()) return;
+    scanStopping = false;
+    unsigned int workers = std::clamp(std::thread::hardware_concurrency(), 2u, 8u);
+    scanThreads.emplace_back(EnumeratorMain);
+    for (unsigned int i = 0; i < workers; ++i) {
+        scanThreads.emplace_back(WorkerMain);
+    }
+}
+
+void StartLibraryScan(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(scanMutex);
+    StartScanThreads();
+    if (!scanProgress.running) {
+        scanProgress.found = 0;
+        scanProgress.scanned = 0;
+    }
+    pendingDirectories.push_back(directory);
+    scanProgress.running = true;
+    scanCv.notify_all();
+}
+
+void StopLibraryScan() {
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        scanStopping = true;
+        pendingDirectories.clear();
+        pendingFiles.clear();
+        pendingProbes.clear();
+    }
+    scanCv.notify_all();
+    for (std::thread& thread : scanThreads) {
+        thread.join();
+    }
+    scanThreads.clear();
+    scanProgress.running = false;
+}
+
+void RequestTrackProbe(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        StartScanThreads();
+        pendingProbes.push_back(path);
+    }
+    scanCv.notify_one();
+}
+
+bool PollScanResults(std::vector<ScanResult>& batch) {
+    batch.clear();
+    std::lock_guard<std::mutex> lock(resultsMutex);
+    if (finishedResults.empty()) return false;
+    batch.swap(finishedResults);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "tagRead.h"
+
+struct ScanResult {
+    std::string path;
+    TrackInfo info;
+    // Set for RequestTrackProbe results; info.picture then still holds the cover image bytes.
+    bool forDisplay = false;
+};
+
+struct ScanProgress {
+    std::atomic<bool> running{false};
+    std::atomic<int> found{0};
+    std::atomic<int> scanned{0};
+};
+
+// Enumerates MP3 files on one thread and probes them on a pool of workers.
+void StartLibraryScan(const std::string& directory);
+void StopLibraryScan();
+// Reads the tags and cover of one track on the scan workers, ahead of any queued library files.
+// The result arrives through PollScanResults with forDisplay set.
+void RequestTrackProbe(const std::string& path);
+
+// Moves every result finished since the last call into batch; returns false when there were none.
+bool PollScanResults(std::vector<ScanResult>& batch);
+
+extern ScanProgress scanProgress;
+
+#endif // SCANNER_H
\ No newline at end of file
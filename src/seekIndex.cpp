@@ -0,0 +1,135 @@
+#include "seekIndex.h"
+#include "libraryIndex.h"
+#include "tagRead.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+static const char seekMagic[8] = { 'E', 'C', 'H', 'O', 'A', 'S', 'I', 'X' };
+
+// Fixed-size part of a sidecar; the UTF-8 track path and then fill int64 offsets follow it.
+struct SeekIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pathLength;
+    uint64_t size;
+    int64_t mtime;
+    int64_t step;
+    uint64_t fill;
+};
+
+static FILE* OpenSidecar(const std::filesystem::path& path, bool write) {
+#ifdef _WIN32
+    return _wfopen(path.c_str(), write ? L"wb" : L"rb");
+#else
+    return fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+std::string GetSeekIndexPath(const std::string& trackPath) {
+    std::string libraryPath = GetLibraryIndexPath();
+    if (libraryPath.empty()) return "";
+
+    uint64_t hash = HashBytes(reinterpret_cast<const unsigned char*>(trackPath.data()), trackPath.size());
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.seek", static_cast<unsigned long long>(hash));
+    return (std::filesystem::u8path(libraryPath).parent_path() / "seek" / name).u8string();
+}
+
+// Opens the sidecar for trackPath positioned at its offsets, or returns null if it is missing or stale.
+static FILE* OpenValidSidecar(const std::string& trackPath, SeekIndexHeader* header) {
+    std::string path = GetSeekIndexPath(trackPath);
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (path.empty() || !StatTrackFile(trackPath, &size, &mtime)) return nullptr;
+
+    FILE* file = OpenSidecar(std::filesystem::u8path(path), false);
+    if (!file) return nullptr;
+
+    std::string storedPath(trackPath.size(), '\0');
+    bool ok = fread(header, sizeof(*header), 1, file) == 1 &&
+              memcmp(header->magic, seekMagic, sizeof(seekMagic)) == 0 &&
+              header->version == SEEK_INDEX_VERSION && header->size == size && header->mtime == mtime &&
+              header->step > 0 && header->fill > 0 && header->fill <= SEEK_INDEX_ENTRIES &&
+              header->pathLength == trackPath.size() &&
+              fread(&storedPath[0], 1, storedPath.size(), file) == storedPath.size() && storedPath == trackPath;
+    if (!ok) {
+        fclose(file);
+        return nullptr;
+    }
+    return file;
+}
+
+bool HasSeekIndex(const std::string& trackPath) {
+    SeekIndexHeader header;
+    FILE* file = OpenValidSidecar(trackPath, &header);
+    if (!file) return false;
+    fclose(file);
+    return true;
+}
+
+bool LoadSeekIndex(const std::string& trackPath, mpg123_handle* mh) {
+    SeekIndexHeader header;
+    FILE* file = OpenValidSidecar(trackPath, &header);
+    if (!file) return false;
+
+    std::vector<int64_t> offsets(header.fill);
+    bool ok = fread(offsets.data(), sizeof(int64_t), offsets.size(), file) == offsets.size();
+    fclose(file);
+    if (!ok) return false;
+
+    return mpg123_set_index64(mh, offsets.data(), header.step, offsets.size()) == MPG123_OK;
+}
+
+bool SaveSeekIndex(const std::string& trackPath, mpg123_handle* mh) {
+    std::string path = GetSeekIndexPath(trackPath);
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (path.empty() || !StatTrackFile(trackPath, &size, &mtime)) return false;
+
+    int64_t* offsets = nullptr;
+    int64_t step = 0;
+    size_t fill = 0;
+    if (mpg123_index64(mh, &offsets, &step, &fill) != MPG123_OK || fill == 0 || step <= 0) return false;
+
+    SeekIndexHeader header;
+    memcpy(header.magic, seekMagic, sizeof(seekMagic));
+    header.version = SEEK_INDEX_VERSION;
+    header.pathLength = static_cast<uint32_t>(trackPath.size());
+    header.size = size;
+    header.mtime = mtime;
+    header.step = step;
+    header.fill = fill;
+
+    // Same temp-and-rename scheme as the library index, so a reader never sees a partial table.
+    std::filesystem::path target = std::filesystem::u8path(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(target.parent_path(), ec);
+
+    FILE* file = OpenSidecar(temp, true);
+    if (!file) {
+        std::cerr << "Failed to write seek index: " << path << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(trackPath.data(), 1, trackPath.size(), file) == trackPath.size() &&
+              fwrite(offsets, sizeof(int64_t), fill, file) == fill;
+    fclose(file);
+    if (!ok) {
+        std::cerr << "Failed to write seek index: " << path << std::endl;
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        std::cerr << "Failed to replace seek index: " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef SEEKINDEX_H
+#define SEEKINDEX_H
+
+#include <mpg123.h>
+#include <string>
+
+#define SEEK_INDEX_VERSION 1
+// Entries kept per file; a 3-hour track then needs at most ~128 frame headers read after a jump.
+#define SEEK_INDEX_ENTRIES 4096
+
+// Frame-offset tables from mpg123_index are cached in one small sidecar file per track under
+// <config dir>/echoa-play/seek, and reused only while the track's size and mtime are unchanged.
+std::string GetSeekIndexPath(const std::string& trackPath);
+
+bool HasSeekIndex(const std::string& trackPath);
+// Installs the cached table on mh with mpg123_set_index64; false if there is no valid cache entry.
+bool LoadSeekIndex(const std::string& trackPath, mpg123_handle* mh);
+// Stores the table mh has built, e.g. after mpg123_scan.
+bool SaveSeekIndex(const std::string& trackPath, mpg123_handle* mh);
+
+#endif // SEEKINDEX_H
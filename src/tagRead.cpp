@@ -1,6 +1,8 @@
 #include "tagRead.h"
-#include <taglib/fileref.h>
+#include <taglib/mpegfile.h>
 #include <taglib/tag.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/attachedpictureframe.h>
 #include <iostream>
 #include <string>
 #include <GLFW/glfw3.h>
@@ -12,39 +14,72 @@
 
 using std::string;
 
-void ReadMP3Tags(const char* filename, string* title, string* artist, string* album, int* year) {
-    std::cerr << "Attempting to read tags for: " << filename << std::endl;
+// 64-bit FNV-1a, used to identify identical cover art across tracks.
+uint64_t HashBytes(const unsigned char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool ProbeTrack(const string& path, TrackInfo* info) {
+    *info = TrackInfo();
 
 #ifdef _WIN32
-    
     std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-    std::wstring wfilename = converter.from_bytes(filename);
-    TagLib::FileRef f(wfilename.c_str());
+    std::wstring wfilename = converter.from_bytes(path);
+    TagLib::MPEG::File file(wfilename.c_str(), true, TagLib::AudioProperties::Average);
 #else
-    TagLib::FileRef f(filename);
+    TagLib::MPEG::File file(path.c_str(), true, TagLib::AudioProperties::Average);
 #endif
 
-    if (!f.isNull() && f.tag()) {
-        TagLib::Tag* tag = f.tag();
-        *title = tag->title().to8Bit(true);
-        *artist = tag->artist().to8Bit(true);
-        *album = tag->album().to8Bit(true);
-        *year = tag->year();
-        std::cerr << "Tags read successfully: Title=" << *title << ", Artist=" << *artist 
-                  << ", Album=" << *album << ", Year=" << *year << std::endl;
+    if (!file.isValid()) {
+        std::cerr << "TagLib could not open file: " << path << std::endl;
+        info->title = "Unknown Title";
+        info->artist = "Unknown Artist";
+        info->album = "Unknown Album";
+        return false;
+    }
+
+    TagLib::Tag* tag = file.tag();
+    if (tag && !tag->isEmpty()) {
+        info->title = tag->title().to8Bit(true);
+        info->artist = tag->artist().to8Bit(true);
+        info->album = tag->album().to8Bit(true);
+        info->year = tag->year();
     } else {
-        std::cerr << "Error reading file or tag: " << filename << std::endl;
-        if (f.isNull()) {
-            std::cerr << "TagLib::FileRef is null (file could not be opened)" << std::endl;
-        } else if (!f.tag()) {
-            std::cerr << "No valid tags found in file" << std::endl;
+        std::cerr << "No valid tags found in file: " << path << std::endl;
+        info->title = "Unknown Title";
+        info->artist = "Unknown Artist";
+        info->album = "Unknown Album";
+    }
+
+    // Length comes from the Xing/VBRI header when present, otherwise from the first frame's bitrate.
+    if (TagLib::MPEG::Properties* props = file.audioProperties()) {
+        info->duration = props->lengthInMilliseconds() / 1000.0f;
+        info->sampleRate = props->sampleRate();
+        info->channels = props->channels();
+    }
+
+    TagLib::ID3v2::Tag* id3v2Tag = file.ID3v2Tag();
+    if (id3v2Tag) {
+        const TagLib::ID3v2::FrameList& frames = id3v2Tag->frameListMap()["APIC"];
+        TagLib::ID3v2::AttachedPictureFrame* cover = nullptr;
+        for (TagLib::ID3v2::Frame* frame : frames) {
+            auto* picture = static_cast<TagLib::ID3v2::AttachedPictureFrame*>(frame);
+            if (!cover || picture->type() == TagLib::ID3v2::AttachedPictureFrame::FrontCover) {
+                cover = picture;
+            }
+        }
+        if (cover) {
+            TagLib::ByteVector bytes = cover->picture();
+            info->picture.assign(bytes.data(), bytes.data() + bytes.size());
+            info->artHash = HashBytes(info->picture.data(), info->picture.size());
         }
-        
-        *title = "Unknown Title";
-        *artist = "Unknown Artist";
-        *album = "Unknown Album";
-        *year = 0;
     }
+    return true;
 }
 
 GLuint LoadTextureFromFile(const char* filename) {
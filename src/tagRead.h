@@ -2,11 +2,26 @@
 #define TAGREAD_H
 
 #include <iostream>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <GLFW/glfw3.h>
 #include <SOIL/SOIL.h>
 
 using std::string;
 
-void ReadMP3Tags(const char* filename, string* title, string* artist, string* album, int* year);
+// Everything the player needs to know about a track, read with a single open of the file.
+struct TrackInfo {
+    string title, artist, album;
+    int year = 0;
+    float duration = 0.0f;
+    int sampleRate = 0;
+    int channels = 0;
+    uint64_t artHash = 0;
+    std::vector<unsigned char> picture;
+};
+
+uint64_t HashBytes(const unsigned char* data, size_t size);
+bool ProbeTrack(const string& path, TrackInfo* info);
 GLuint LoadTextureFromFile(const char* filename);
 #endif // TAGREAD_H
\ No newline at end of file
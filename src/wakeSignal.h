@@ -0,0 +1,94 @@
+#ifndef WAKESIGNAL_H
+#define WAKESIGNAL_H
+
+#include <atomic>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <ctime>
+#include <semaphore.h>
+#endif
+
+// Wakes one waiting thread without taking a lock, so it can be signalled from OpenAL's mixer
+// thread. The pending flag coalesces wakes: at most one semaphore post is outstanding between
+// two waits however often notify() is called.
+class WakeSignal {
+public:
+    WakeSignal() {
+#ifdef _WIN32
+        semaphore = CreateSemaphoreW(nullptr, 0, 1, nullptr);
+#elif defined(__APPLE__)
+        semaphore = dispatch_semaphore_create(0);
+#else
+        sem_init(&semaphore, 0, 0);
+#endif
+    }
+
+    ~WakeSignal() {
+#ifdef _WIN32
+        CloseHandle(semaphore);
+#elif defined(__APPLE__)
+        dispatch_release(semaphore);
+#else
+        sem_destroy(&semaphore);
+#endif
+    }
+
+    WakeSignal(const WakeSignal&) = delete;
+    WakeSignal& operator=(const WakeSignal&) = delete;
+
+    // Safe from any thread, including realtime ones.
+    void notify() {
+        if (pending.exchange(true, std::memory_order_acq_rel)) return;
+#ifdef _WIN32
+        ReleaseSemaphore(semaphore, 1, nullptr);
+#elif defined(__APPLE__)
+        dispatch_semaphore_signal(semaphore);
+#else
+        sem_post(&semaphore);
+#endif
+    }
+
+    // Returns after a notify() or once milliseconds have passed; a negative timeout waits for the
+    // notify() only. Everything the notifying thread wrote before notify() is visible afterwards.
+    void wait(int milliseconds) {
+#ifdef _WIN32
+        WaitForSingleObject(semaphore, milliseconds < 0 ? INFINITE : static_cast<DWORD>(milliseconds));
+#elif defined(__APPLE__)
+        dispatch_semaphore_wait(semaphore, milliseconds < 0 ? DISPATCH_TIME_FOREVER
+            : dispatch_time(DISPATCH_TIME_NOW, static_cast<int64_t>(milliseconds) * 1000000));
+#else
+        if (milliseconds < 0) {
+            while (sem_wait(&semaphore) != 0 && errno == EINTR) {
+            }
+        } else {
+            timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += milliseconds / 1000;
+            deadline.tv_nsec += static_cast<long>(milliseconds % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            while (sem_timedwait(&semaphore, &deadline) != 0 && errno == EINTR) {
+            }
+        }
+#endif
+        pending.exchange(false, std::memory_order_acq_rel);
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE semaphore;
+#elif defined(__APPLE__)
+    dispatch_semaphore_t semaphore;
+#else
+    sem_t semaphore;
+#endif
+    std::atomic<bool> pending{false};
+};
+
+#endif // WAKESIGNAL_H
@@ -0,0 +1,298 @@
+#include "wavExport.h"
+#include "playmusic.h"
+#include "decoderPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+
+static fs::path WavPath(const fs::path& outputDir, const fs::path& relative) {
+    fs::path out = outputDir / relative;
+    out.replace_extension(".wav");
+    return out;
+}
+
+static void CollectPlaylist(const fs::path& playlist, const fs::path& outputDir, std::vector<WavExportJob>* jobs) {
+    std::ifstream in(playlist);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        fs::path track = fs::u8path(line);
+        if (track.is_relative()) track = playlist.parent_path() / track;
+        jobs->push_back({track.u8string(), WavPath(outputDir, track.filename()).u8string()});
+    }
+}
+
+// Output names are compared case-insensitively, as the file system would on Windows.
+static std::string OutputKey(const std::string& output) {
+    std::string key = fs::u8path(output).lexically_normal().generic_u8string();
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+
+// Drops jobs from `first` on that repeat an earlier input, and renames outputs that collide with an
+// earlier job's to "name (2).wav", "name (3).wav", ... so same-named tracks from different folders
+// don't overwrite each other.
+static void DisambiguateOutputs(std::vector<WavExportJob>* jobs, size_t first) {
+    std::unordered_set<std::string> inputs;
+    std::unordered_set<std::string> outputs;
+    for (size_t i = 0; i < first; ++i) {
+        inputs.insert(fs::u8path((*jobs)[i].input).lexically_normal().u8string());
+        outputs.insert(OutputKey((*jobs)[i].output));
+    }
+    std::vector<WavExportJob> added(jobs->begin() + static_cast<std::ptrdiff_t>(first), jobs->end());
+    jobs->resize(first);
+    for (WavExportJob& job : added) {
+        if (!inputs.insert(fs::u8path(job.input).lexically_normal().u8string()).second) continue;
+        if (!outputs.insert(OutputKey(job.output)).second) {
+            fs::path out = fs::u8path(job.output);
+            fs::path stem = out.parent_path() / out.stem();
+            for (int n = 2;; ++n) {
+                fs::path candidate = stem;
+                candidate += fs::u8path(" (" + std::to_string(n) + ").wav");
+                if (outputs.insert(OutputKey(candidate.u8string())).second) {
+                    std::cerr << "Output name already used, writing " << candidate.u8string() << " for " << job.input << std::endl;
+                    job.output = candidate.u8string();
+                    break;
+                }
+            }
+        }
+        jobs->push_back(std::move(job));
+    }
+}
+
+static void CollectJobs(const std::string& path, const std::string& outputDir, std::vector<WavExportJob>* jobs) {
+    fs::path root = fs::u8path(path);
+    fs::path outRoot = fs::u8path(outputDir);
+    std::error_code ec;
+    if (fs::is_directory(root, ec)) {
+        std::vector<WavExportJob> found;
+        for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+             it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".mp3") {
+                found.push_back({it->path().u8string(), WavPath(outRoot, it->path().lexically_relative(root)).u8string()});
+            }
+        }
+        std::sort(found.begin(), found.end(), [](const WavExportJob& a, const WavExportJob& b) { return a.input < b.input; });
+        jobs->insert(jobs->end(), found.begin(), found.end());
+        return;
+    }
+    std::string ext = root.extension().string();
+    if (ext == ".m3u" || ext == ".m3u8") {
+        CollectPlaylist(root, outRoot, jobs);
+        return;
+    }
+    jobs->push_back({root.u8string(), WavPath(outRoot, root.filename()).u8string()});
+}
+
+void CollectWavExportJobs(const std::string& path, const std::string& outputDir, std::vector<WavExportJob>* jobs) {
+    size_t first = jobs->size();
+    CollectJobs(path, outputDir, jobs);
+    DisambiguateOutputs(jobs, first);
+}
+
+static void Put16(unsigned char*& p, uint16_t v) {
+    p[0] = static_cast<unsigned char>(v);
+    p[1] = static_cast<unsigned char>(v >> 8);
+    p += 2;
+}
+
+static void Put32(unsigned char*& p, uint32_t v) {
+    Put16(p, static_cast<uint16_t>(v));
+    Put16(p, static_cast<uint16_t>(v >> 16));
+}
+
+// Canonical RIFF header; float files get the 18-byte fmt chunk and the fact chunk the spec asks for.
+// Returns the header size.
+static size_t BuildWavHeader(unsigned char* header, bool isFloat, int channels, long rate, uint32_t dataBytes) {
+    int sampleBytes = isFloat ? 4 : 2;
+    uint32_t blockAlign = static_cast<uint32_t>(channels * sampleBytes);
+    uint32_t fmtBytes = isFloat ? 18 : 16;
+    uint32_t factBytes = isFloat ? 12 : 0;
+    unsigned char* p = header;
+
+    memcpy(p, "RIFF", 4); p += 4;
+    Put32(p, 4 + (8 + fmtBytes) + factBytes + 8 + dataBytes);
+    memcpy(p, "WAVE", 4); p += 4;
+    memcpy(p, "fmt ", 4); p += 4;
+    Put32(p, fmtBytes);
+    Put16(p, isFloat ? WAV_FORMAT_IEEE_FLOAT : WAV_FORMAT_PCM);
+    Put16(p, static_cast<uint16_t>(channels));
+    Put32(p, static_cast<uint32_t>(rate));
+    Put32(p, static_cast<uint32_t>(rate) * blockAlign);
+    Put16(p, static_cast<uint16_t>(blockAlign));
+    Put16(p, static_cast<uint16_t>(sampleBytes * 8));
+    if (isFloat) {
+        Put16(p, 0);
+        memcpy(p, "fact", 4); p += 4;
+        Put32(p, 4);
+        Put32(p, dataBytes / blockAlign);
+    }
+    memcpy(p, "data", 4); p += 4;
+    Put32(p, dataBytes);
+    return static_cast<size_t>(p - header);
+}
+
+// Decodes one track into block and writes each full block with a single unbuffered write. The
+// header goes first with a zero data size and is rewritten once the size is known.
+static bool ExportTrack(const WavExportJob& job, bool floatSamples, std::vector<unsigned char>& block,
+                        double* audioSeconds, uint64_t* bytesWritten) {
+    long rate;
+    int channels;
+    int encoding = floatSamples ? MPG123_ENC_FLOAT_32 : MPG123_ENC_SIGNED_16;
+    mpg123_handle* mh = OpenTrackDecoder(job.input.c_str(), &rate, &channels, &encoding);
+    if (!mh) return false;
+    bool isFloat = encoding == MPG123_ENC_FLOAT_32;
+    if (floatSamples && !isFloat) {
+        std::cerr << "Float output not supported by this mpg123 build, writing 16-bit: " << job.input << std::endl;
+    }
+
+    std::error_code ec;
+    fs::path outPath = fs::u8path(job.output);
+    fs::create_directories(outPath.parent_path(), ec);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(nullptr, 0);
+    out.open(outPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to create " << job.output << std::endl;
+        CloseTrackDecoder(mh);
+        return false;
+    }
+
+    unsigned char header[64];
+    size_t headerBytes = BuildWavHeader(header, isFloat, channels, rate, 0);
+    out.write(reinterpret_cast<const char*>(header), static_cast<std::streamsize>(headerBytes));
+
+    uint64_t dataBytes = 0;
+    bool decoding = true;
+    while (decoding && out) {
+        size_t filled = 0;
+        while (filled < block.size()) {
+            size_t done = 0;
+            int err = mpg123_read(mh, block.data() + filled, block.size() - filled, &done);
+            filled += done;
+            if (err != MPG123_OK && err != MPG123_NEW_FORMAT) {
+                if (err != MPG123_DONE) {
+                    std::cerr << "Decode error in " << job.input << ": " << mpg123_strerror(mh) << std::endl;
+                }
+                decoding = false;
+                break;
+            }
+        }
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(filled));
+        dataBytes += filled;
+    }
+    CloseTrackDecoder(mh);
+
+    // RIFF sizes are 32-bit; anything longer cannot be a valid WAV file.
+    bool fits = dataBytes + headerBytes <= 0xFFFFFFFFull;
+    if (!fits) {
+        std::cerr << "Track too long for a WAV file: " << job.input << std::endl;
+    } else {
+        BuildWavHeader(header, isFloat, channels, rate, static_cast<uint32_t>(dataBytes));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(header), static_cast<std::streamsize>(headerBytes));
+    }
+    out.close();
+    if (!fits || !out) {
+        fs::remove(outPath, ec);
+        return false;
+    }
+
+    uint64_t frameBytes = static_cast<uint64_t>(channels) * (isFloat ? 4 : 2);
+    *audioSeconds = static_cast<double>(dataBytes / frameBytes) / rate;
+    *bytesWritten = dataBytes + headerBytes;
+    return true;
+}
+
+WavExportStats ExportWavFiles(const std::vector<WavExportJob>& jobs, bool floatSamples, unsigned workers) {
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<unsigned>(workers, static_cast<unsigned>(std::max<size_t>(jobs.size(), 1)));
+
+    WavExportStats stats;
+    std::atomic<size_t> nextJob{0};
+    std::mutex statsMutex;
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        std::vector<unsigned char> block(WAV_EXPORT_BLOCK_BYTES);
+        size_t i;
+        while ((i = nextJob.fetch_add(1)) < jobs.size()) {
+            double audioSeconds = 0.0;
+            uint64_t bytesWritten = 0;
+            bool ok = ExportTrack(jobs[i], floatSamples, block, &audioSeconds, &bytesWritten);
+
+            std::lock_guard<std::mutex> lock(statsMutex);
+            if (ok) {
+                stats.exported++;
+                stats.audioSeconds += audioSeconds;
+                stats.bytesWritten += bytesWritten;
+                std::cerr << "Exported " << jobs[i].output << std::endl;
+            } else {
+                stats.failed++;
+                std::cerr << "Failed to export " << jobs[i].input << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    stats.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+int RunWavExport(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: echoa-play --export-wav <output dir> [--float] [--jobs N] <file|folder|playlist>..." << std::endl;
+        return 2;
+    }
+    std::string outputDir = argv[0];
+    bool floatSamples = false;
+    unsigned workers = 0;
+    std::vector<WavExportJob> jobs;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--float") == 0) {
+            floatSamples = true;
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            CollectWavExportJobs(argv[i], outputDir, &jobs);
+        }
+    }
+    if (jobs.empty()) {
+        std::cerr << "No tracks to export" << std::endl;
+        return 2;
+    }
+
+    if (!InitDecoderPool()) return 1;
+    WavExportStats stats = ExportWavFiles(jobs, floatSamples, workers);
+    ShutdownDecoderPool();
+
+    double elapsed = std::max(stats.elapsedSeconds, 1e-9);
+    std::printf("%d exported, %d failed: %.1f s of audio in %.2f s (%.1fx realtime, %.1f MB/s)\n", stats.exported,
+                stats.failed, stats.audioSeconds, stats.elapsedSeconds, stats.audioSeconds / elapsed,
+                static_cast<double>(stats.bytesWritten) / (1024.0 * 1024.0) / elapsed);
+    return stats.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#ifndef WAVEXPORT_H
+#define WAVEXPORT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Each worker decodes into one buffer of this size and writes it out whole, so memory use is
+// bounded by workers * WAV_EXPORT_BLOCK_BYTES however long the tracks are.
+#define WAV_EXPORT_BLOCK_BYTES (4 * 1024 * 1024)
+
+struct WavExportJob {
+    std::string input;
+    std::string output;
+};
+
+struct WavExportStats {
+    int exported = 0;
+    int failed = 0;
+    double audioSeconds = 0.0;
+    uint64_t bytesWritten = 0;
+    double elapsedSeconds = 0.0;
+};
+
+// Expands a file, a folder (recursively, *.mp3) or an .m3u/.m3u8 playlist into jobs writing to
+// outputDir. Folder contents keep their relative layout; other tracks go directly into outputDir.
+// Inputs already in jobs are skipped, and an output name already taken gets a " (2)", " (3)", ... suffix.
+void CollectWavExportJobs(const std::string& path, const std::string& outputDir, std::vector<WavExportJob>* jobs);
+
+// Decodes every job to a RIFF/WAV file, 16-bit or 32-bit float, on `workers` threads (0 means one per core).
+WavExportStats ExportWavFiles(const std::vector<WavExportJob>& jobs, bool floatSamples, unsigned workers);
+
+// Command line entry: <output dir> [--float] [--jobs N] <file|folder|playlist>...
+int RunWavExport(int argc, char** argv);
+
+#endif // WAVEXPORT_H